@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <string>
+
+using namespace std;
+
+enum ACQuantity {
+    AC_MAGNITUDE = 0,
+    AC_PHASE = 1,        // Degrees, unwrapped along the sweep
+    AC_MAGNITUDE_DB = 2,
+    AC_GROUP_DELAY = 3   // Seconds, -d(phase)/d(omega)
+};
+
+// Complete complex solution of the last AC sweep. values holds one column per
+// unknown (node voltages, then AC source branch currents) and every column
+// lists all frequencies contiguously, so a column is copied out with a single
+// memcpy. Magnitude, phase, dB and group delay are derived only on request.
+class ACSweepResult {
+public:
+    vector<double> frequencies;
+    vector<string> unknownNames;
+    vector<complex<double>> values;
+
+    void reset(const vector<string>& names, const vector<double>& freqs);
+    void clear();
+
+    size_t pointCount() const;
+    size_t unknownCount() const;
+    int findUnknown(const string& name) const;
+
+    complex<double>* column(int k);
+    const complex<double>* column(int k) const;
+
+    // Derives a real quantity from a column of pointCount() complex values.
+    vector<double> derive(const complex<double>* data, ACQuantity quantity) const;
+};
@@ -2,9 +2,106 @@
 
 #include "Circuit.h"
 #include "export.h" 
+#include <ostream>
 
-CIRCUITSIMULATOR_API void dcAnalysis(Circuit& circuit);
-CIRCUITSIMULATOR_API void transientAnalysis(Circuit& circuit, double t_step, double t_stop);
+// How the conducting states of ideal diodes are found
+enum class DiodeSolverType {
+    RELAXATION, // Flip diode states one full solve at a time until nothing changes
+    LCP         // Lemke pivoting on the diode complementarity problem, then verify
+};
+
+// How each AC sweep point is solved
+enum class ACSolverType {
+    DIRECT,       // Full sparse LU at every frequency
+    REDUCED_ORDER // Krylov-projected model, full solve only where its residual is too large
+};
+
+// warmStart keeps the diode states and operating point of the previous solve
+// as the starting guess instead of resetting every diode to off.
+CIRCUITSIMULATOR_API void dcAnalysis(Circuit& circuit, DiodeSolverType diodeSolver = DiodeSolverType::RELAXATION, bool warmStart = false);
+CIRCUITSIMULATOR_API void transientAnalysis(Circuit& circuit, double t_step, double t_stop, DiodeSolverType diodeSolver = DiodeSolverType::RELAXATION);
 CIRCUITSIMULATOR_API void dcSweepAnalysis(Circuit& circuit, const std::string& sourceName, double start, double end, double step);
-CIRCUITSIMULATOR_API void acSweepAnalysis(Circuit& circuit, const std::string& sourceName, double start_freq, double stop_freq, int num_points, const std::string& sweep_type);
+// sweep_type is "Linear", "Logarithmic" or "Adaptive". Adaptive starts from a
+// coarse log grid and refines where the response bends; num_points is then the
+// point budget rather than the exact count.
+CIRCUITSIMULATOR_API void acSweepAnalysis(Circuit& circuit, const std::string& sourceName, double start_freq, double stop_freq, int num_points, const std::string& sweep_type, ACSolverType acSolver = ACSolverType::DIRECT);
 CIRCUITSIMULATOR_API void phaseSweepAnalysis(Circuit& circuit, const std::string& sourceName, double base_freq, double start_phase, double stop_phase, int num_points);
+
+// Graph check of the circuit as the given analysis assembles it, in near-linear
+// time: voltage source loops (with inductors as shorts in DC), floating node
+// groups and current source cutsets, each with the elements involved. Floating
+// groups are tied to ground or rejected per floatingNodePolicy(). Every
+// analysis runs it before assembly and stops on a rejected circuit, leaving
+// NaN node voltages; the report is kept in circuit.topology. tieAllFloating
+// ties every floating group to ground, cutsets included, whatever the policy.
+CIRCUITSIMULATOR_API TopologyReport checkTopology(const Circuit& circuit, AnalysisType type, bool tieAllFloating = false);
+
+// The DC operating point a transient starts from. Only the transient graph
+// decides rejection: groups floating or fed by current sources in DC alone are
+// tied to ground through the shunt, as the transient starts every capacitor
+// from zero anyway, and a DC-only inductor loop starts from zero voltages.
+// Leaves the transient report in circuit.topology; false if it rejects.
+CIRCUITSIMULATOR_API bool transientOperatingPoint(Circuit& circuit, DiodeSolverType diodeSolver = DiodeSolverType::RELAXATION);
+
+// Adjoint sensitivities of one output (node voltage, or voltage source /
+// inductor current in DC; any AC unknown in AC) to every R, C, L and source
+// value, from one transposed solve. AC sensitivities are of the complex
+// phasor at the given frequency.
+CIRCUITSIMULATOR_API bool dcSensitivityAnalysis(Circuit& circuit, const std::string& output, vector<pair<string, double>>& sensitivities);
+CIRCUITSIMULATOR_API bool acSensitivityAnalysis(Circuit& circuit, const std::string& output, double frequency, vector<pair<string, complex<double>>>& sensitivities);
+
+// One analysis with its settings, as run repeatedly by the Monte Carlo and
+// parameter sweep drivers. Outputs are node voltages sampled onto axis(); for
+// AC_SWEEP they are magnitudes.
+struct AnalysisRequest {
+    AnalysisType analysis = AnalysisType::DC;
+
+    double t_step = 0.0;         // TRANSIENT
+    double t_stop = 0.0;
+
+    string acSource;             // AC_SWEEP
+    double f_start = 0.0;
+    double f_stop = 0.0;
+    int ac_points = 0;
+    string sweep_type = "Logarithmic";
+
+    // Reports the first problem with the settings or outputs on cerr
+    bool validate(Circuit& circuit, const vector<string>& outputs) const;
+    // DC: {0}, transient: every step time, AC: the non-adaptive frequency grid
+    vector<double> axis() const;
+    // warmStart continues a DC solve from the diode states already in the circuit
+    void run(Circuit& circuit, bool warmStart = false) const;
+    // Writes outputs.size() x axis.size() samples, row-major; false if any is not finite
+    bool sample(Circuit& circuit, const vector<string>& outputs, const vector<double>& axis, double* values) const;
+};
+
+// Streams the analyses write their progress lines and warnings to: cout and
+// cerr, or a sink dropping everything while the calling thread is quiet
+CIRCUITSIMULATOR_API std::ostream& analysisOutput();
+CIRCUITSIMULATOR_API std::ostream& analysisErrors();
+// Silences the analyses on the calling thread only, so drivers running many of
+// them on pool threads stay quiet without touching other threads; returns the
+// previous setting for the caller to restore
+CIRCUITSIMULATOR_API bool setThreadQuiet(bool quiet);
+
+// Monte Carlo over circuit.componentVariations: every trial copies the circuit,
+// draws its component values from its own RNG stream (seeded from seed and the
+// trial index) and runs the chosen analysis. Only running statistics are kept.
+struct MonteCarloOptions : AnalysisRequest {
+    int trials = 1000;
+    uint64_t seed = 1;
+    vector<string> outputs;
+    int histogramBins = 20;
+};
+
+CIRCUITSIMULATOR_API bool monteCarloAnalysis(Circuit& circuit, const MonteCarloOptions& options, MonteCarloResult& result);
+
+// Nested .step sweep over circuit.stepParameters around the chosen analysis.
+// Grid points run in parallel in contiguous blocks of the innermost parameter,
+// each block on its own circuit copy, so neighbouring points reuse the DC
+// diode states and the AC pivot pattern of the point before them.
+struct ParameterSweepOptions : AnalysisRequest {
+    vector<string> outputs;
+};
+
+CIRCUITSIMULATOR_API bool parameterSweepAnalysis(Circuit& circuit, const ParameterSweepOptions& options, ParameterSweepResult& result);
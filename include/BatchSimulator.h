@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Analysis.h"
+#include "export.h"
+
+// Instances solved together, one per lane of the structure-of-arrays matrices
+const int BATCH_LANES = 8;
+
+// True when the circuit has no diodes. Its MNA matrix then depends on component
+// values only, so all instances of the topology share one structure, DC needs
+// a single solve and a fixed-step transient a single factorization.
+CIRCUITSIMULATOR_API bool isBatchable(const Circuit& circuit);
+
+// Runs a DC or fixed-step transient request for many instances of one
+// topology, BATCH_LANES at a time. Instance k sets parameters[p] to values[k][p]
+// (names as for Circuit::findComponentValue). samples[k] receives
+// outputs.size() x request.axis() values, row-major as from
+// AnalysisRequest::sample, and ok[k] whether they are all finite. Returns
+// false when the circuit, request or names cannot be batched.
+CIRCUITSIMULATOR_API bool batchedAnalysis(const Circuit& circuit, const AnalysisRequest& request,
+                                          const vector<string>& parameters, const vector<vector<double>>& values,
+                                          const vector<string>& outputs,
+                                          vector<vector<double>>& samples, vector<char>& ok);
@@ -19,6 +19,12 @@ class Component;
 #include "CurrentSource.h"
 #include "ACVoltageSource.h"
 #include "Component.h"
+#include "ACSweepResult.h"
+#include "ReducedOrderModel.h"
+#include "MonteCarlo.h"
+#include "ParameterSweep.h"
+#include "Topology.h"
+#include "LinearSolver.h"
 
 using namespace std;
 
@@ -29,6 +35,40 @@ enum class AnalysisType {
 };
 
 
+// Frequency-independent pieces of the AC system, assembled once per sweep:
+//     A(w) = G + jw*C + Gamma/(jw)
+// G holds conductances and source incidence, C capacitances and Gamma
+// reciprocal inductances. nonzeros is the union of their sparsity patterns.
+struct ACSystemParts {
+    vector<vector<double>> G;
+    vector<vector<double>> C;
+    vector<vector<double>> Gamma;
+    vector<pair<int, int>> nonzeros;
+
+    // Writes G + jw*C + Gamma/(jw) into the nonzero positions of A. A must
+    // already be sized and hold zeros everywhere else.
+    void form(double omega, vector<vector<complex<double>>>& A) const;
+    // The same values as one entry per nonzero, in its order
+    void formEntries(double omega, vector<complex<double>>& entries) const;
+};
+
+// Diode bias at the DC operating point, which is all the small-signal AC model
+// needs. Kept with the fingerprint of the DC circuit it was solved for, so
+// repeated AC analyses on the same bias skip the DC solve.
+struct OperatingPointCache {
+    bool valid = false;
+    uint64_t fingerprint = 0;
+    vector<DiodeState> diodeStates;
+    vector<double> diodeConductances; // dI/dV at the bias point (Shockley diodes)
+};
+
+// Pivot order of the last AC system, kept while its nonzero pattern is unchanged
+// so re-running AC on new component values skips the symbolic analysis
+struct ACPatternCache {
+    vector<pair<int, int>> nonzeros;
+    SparseLUPattern pattern;
+};
+
 class Circuit {
 public:
     vector<Node*> nodes;
@@ -42,13 +82,35 @@ public:
     vector<string> groundNodeNames;
 
     double delta_t;
+    double gmin;        // Shunt conductance from every node to ground (gmin stepping)
+    double sourceScale; // Multiplier on independent DC sources (source stepping)
 
     vector<vector<double>> MNA_A;
     vector<double> MNA_RHS;
 
+    vector<double> MNA_solution;
+
     vector<vector<complex<double>>> MNA_A_Complex;
     vector<complex<double>> MNA_RHS_Complex;
-    
+
+    ACSweepResult acResult; // Complex solution of every unknown from the last AC sweep
+    ReducedACModel acReducedModel; // Last reduced AC model, reused while the system is unchanged
+    OperatingPointCache operatingPoint; // Bias used to linearize diodes for AC
+
+    vector<ComponentVariation> componentVariations; // Tolerances used by Monte Carlo runs
+    MonteCarloResult monteCarloResult;
+    ACPatternCache acPattern;
+    TopologyReport topology; // Last topology check; its shunts go into every assembly
+
+    vector<StepParameter> stepParameters; // Nested .step dimensions, outermost first
+    ParameterSweepResult parameterSweepResult;
+
+    Circuit();
+    ~Circuit();
+    // Deep copies: nodes are duplicated and every component is relinked to them
+    Circuit(const Circuit& other);
+    Circuit& operator=(const Circuit& other);
+
     vector<vector<double>> G();
     vector<vector<double>> B();
     vector<vector<double>> C();
@@ -67,14 +129,33 @@ public:
     CurrentSource* findCurrentSource(const string& name);
     VoltageSource* findVoltageSource(const string& name);
     ACVoltageSource* findACVoltageSource(const string& name);
+    // The value a .step or tolerance acts on, or nullptr for an unknown name
+    double* findComponentValue(const string& name);
 
     bool deleteResistor(const string& name);
+    bool deleteCapacitor(const string& name);
+    bool deleteInductor(const string& name);
+    bool deleteDiode(const string& name);
+    bool deleteVoltageSource(const string& name);
+    bool deleteCurrentSource(const string& name);
     void set_MNA_A(AnalysisType type, double frequency = 0);
     void set_MNA_RHS(AnalysisType type, double frequency = 0);
+    void buildACSystemParts(ACSystemParts& parts) const;
+    void assembleACMatrix(double frequency, vector<vector<complex<double>>>& A) const;
+    void assembleACRHS(vector<complex<double>>& rhs) const;
+    bool acComponentCurrent(const string& name, vector<complex<double>>& current) const;
+    vector<string> acUnknownNames() const;
+    uint64_t dcFingerprint() const;
+    void MNA_sol_size();
 
     void setDeltaT(double dt);
+    void setGmin(double g);
+    void setSourceScale(double scale);
     void updateComponentStates();
     void clearComponentHistory();
+    // Also drops the AC, Monte Carlo and .step results and setups, so copies made per trial stay cheap
+    void clearStoredResults();
+    bool isNodeNameGround(const string& node_name) const;
     int getNodeMatrixIndex(const Node* target_node_ptr) const;
     int countNonGroundNodes() const;
     int countTotalExtraVariables();
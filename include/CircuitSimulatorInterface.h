@@ -9,6 +9,7 @@
 #define CIRCUIT_SIM_ERROR_INVALID_ARGUMENT -1
 #define CIRCUIT_SIM_ERROR_NOT_FOUND -2
 #define CIRCUIT_SIM_ERROR_ANALYSIS_FAILED -3
+#define CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY -4 // Floating nodes, voltage source loop or current source cutset; see GetTopologyReport
 
 extern "C" {
     CIRCUITSIMULATOR_API void* CreateCircuit();
@@ -17,14 +18,47 @@ extern "C" {
     CIRCUITSIMULATOR_API int AddResistor(void* circuit, const char* name, const char* node1, const char* node2, double value);
     CIRCUITSIMULATOR_API int AddVoltageSource(void* circuit, const char* name, const char* node1, const char* node2, double voltage);
     CIRCUITSIMULATOR_API int AddACVoltageSource(void* circuit, const char* name, const char* node1, const char* node2, double magnitude, double phase);
+    CIRCUITSIMULATOR_API int AddDiode(void* circuit, const char* name, const char* anode, const char* cathode, double forwardVoltage, double zenerVoltage);
+    CIRCUITSIMULATOR_API int SetDiodeShockleyModel(void* circuit, const char* name, double saturationCurrent, double emissionCoefficient);
     CIRCUITSIMULATOR_API int SetGroundNode(void* circuit, const char* nodeName);
     CIRCUITSIMULATOR_API int RunDCAnalysis(void* circuit);
+    CIRCUITSIMULATOR_API int RunDCAnalysisWithDiodeSolver(void* circuit, int diodeSolver);
     CIRCUITSIMULATOR_API int RunTransientAnalysis(void* circuit, double stepTime, double stopTime);
+    CIRCUITSIMULATOR_API int RunWaveformRelaxationTransient(void* circuit, double stepTime, double stopTime, int gaussSeidel, int compareMonolithic, double* maxDeviation, double* bypassedFraction);
     CIRCUITSIMULATOR_API int RunACAnalysis(void* circuit, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType);
+    CIRCUITSIMULATOR_API int RunReducedACAnalysis(void* circuit, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType);
+    CIRCUITSIMULATOR_API int ExportReducedACModel(void* circuit, const char* path);
+    CIRCUITSIMULATOR_API int ImportReducedACModel(void* circuit, const char* path);
+    CIRCUITSIMULATOR_API int SetComponentTolerance(void* circuit, const char* componentName, int distribution, double tolerance);
+    CIRCUITSIMULATOR_API int ClearComponentTolerances(void* circuit);
+    CIRCUITSIMULATOR_API int RunMonteCarloDC(void* circuit, const char* outputNodes, int trials, unsigned long long seed);
+    CIRCUITSIMULATOR_API int RunMonteCarloTransient(void* circuit, const char* outputNodes, int trials, unsigned long long seed, double stepTime, double stopTime);
+    CIRCUITSIMULATOR_API int RunMonteCarloAC(void* circuit, const char* outputNodes, int trials, unsigned long long seed, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType);
+    CIRCUITSIMULATOR_API int GetMonteCarloAxis(void* circuit, double* axis, int maxCount);
+    CIRCUITSIMULATOR_API int GetMonteCarloStatistics(void* circuit, const char* outputNode, double* mean, double* stddev, double* minimum, double* maximum, int maxCount);
+    CIRCUITSIMULATOR_API int GetMonteCarloHistogram(void* circuit, const char* outputNode, double* range, int* counts, int maxBins);
+    CIRCUITSIMULATOR_API int AddStepParameter(void* circuit, const char* componentName, const double* values, int count);
+    CIRCUITSIMULATOR_API int ClearStepParameters(void* circuit);
+    CIRCUITSIMULATOR_API int RunStepDC(void* circuit, const char* outputNodes);
+    CIRCUITSIMULATOR_API int RunStepTransient(void* circuit, const char* outputNodes, double stepTime, double stopTime);
+    CIRCUITSIMULATOR_API int RunStepAC(void* circuit, const char* outputNodes, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType);
+    CIRCUITSIMULATOR_API int GetStepShape(void* circuit, int* shape, int maxDims);
+    CIRCUITSIMULATOR_API int GetStepAxis(void* circuit, double* axis, int maxCount);
+    CIRCUITSIMULATOR_API int GetStepResult(void* circuit, const char* outputNode, double* values, int maxCount);
+    CIRCUITSIMULATOR_API int SetTearingPartitions(int partitions);
+    CIRCUITSIMULATOR_API int GetTearingStatistics(long long* solves, int* subdomains, int* interfaceSize, int* unknowns, double* loadBalance);
+    CIRCUITSIMULATOR_API int SetSeriesReduction(int enable);
+    CIRCUITSIMULATOR_API int SetFloatingNodePolicy(int reject);
+    CIRCUITSIMULATOR_API int GetTopologyReport(void* circuit, char* buffer, int bufferSize);
     CIRCUITSIMULATOR_API int GetNodeVoltage(void* circuit, const char* nodeName, double* voltage);
     CIRCUITSIMULATOR_API int GetNodeNames(void* circuit, char* nodeNamesBuffer, int bufferSize);
     CIRCUITSIMULATOR_API int GetNodeVoltageHistory(void* circuit, const char* nodeName, double* timePoints, double* voltages, int maxCount);
     CIRCUITSIMULATOR_API int GetNodeSweepHistory(void* circuit, const char* nodeName, double* frequencies, double* magnitudes, int maxCount);
+    CIRCUITSIMULATOR_API int GetACFrequencies(void* circuit, double* frequencies, int maxCount);
+    CIRCUITSIMULATOR_API int GetACSolution(void* circuit, const char* name, double* realImag, int maxCount);
+    CIRCUITSIMULATOR_API int GetACResponse(void* circuit, const char* name, int quantity, double* values, int maxCount);
+    CIRCUITSIMULATOR_API int GetDCSensitivities(void* circuit, const char* outputName, char* parameterNames, int bufferSize, double* sensitivities, int maxCount);
+    CIRCUITSIMULATOR_API int GetACSensitivities(void* circuit, const char* outputName, double frequency, char* parameterNames, int bufferSize, double* realImag, int maxCount);
     CIRCUITSIMULATOR_API int GetComponentCurrentHistory(void* circuit, const char* componentName, double* timePoints, double* currents, int maxCount);
     CIRCUITSIMULATOR_API int GetAllVoltageSourceNames(void* circuit, char* vsNamesBuffer, int bufferSize);
     CIRCUITSIMULATOR_API int GetVoltageSourceCurrent(void* circuit, const char* vsName, double* current);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Matrix indices of one two-terminal component; -1 is ground
+struct Terminals {
+    int n1;
+    int n2;
+};
+
+// Linear two-terminal components in the order of the scalar DC/transient MNA
+// system: n node unknowns, then voltage source currents, then inductor
+// currents, N in all. Assemblers that keep their own copy of the topology
+// (batched lanes, waveform relaxation partitions) stamp it through the two
+// functions below, so they build the same system as Circuit::set_MNA_A.
+struct CompanionTopology {
+    int n = 0;
+    int N = 0;
+    vector<Terminals> resistors, capacitors, inductors, voltageSources, currentSources;
+    vector<int> shuntNodes; // Nodes the topology check ties to ground
+    double shuntConductance = 0.0;
+};
+
+// Backward Euler companion matrix with step h, added to a zeroed A.
+// values.conductance(i), .capacitance(i) and .inductance(i) return the value
+// of component i as a scalar or per-lane type V supporting V * double and -V;
+// A.add(i, j, v) accumulates v (or a plain double, for the shunts) into entry
+// (i, j) and A.set(i, j, 1.0) writes a voltage source or inductor incidence entry.
+template <typename Values, typename Matrix>
+void stampCompanionMatrix(const CompanionTopology& t, double h, const Values& values, Matrix& A) {
+    auto stamp = [&](const Terminals& c, const auto& g) {
+        if (c.n1 == c.n2) return;
+        if (c.n1 != -1) A.add(c.n1, c.n1, g);
+        if (c.n2 != -1) A.add(c.n2, c.n2, g);
+        if (c.n1 != -1 && c.n2 != -1) {
+            A.add(c.n1, c.n2, -g);
+            A.add(c.n2, c.n1, -g);
+        }
+    };
+    auto stampBranch = [&](const Terminals& c, int k) {
+        if (c.n1 != -1) {
+            A.set(c.n1, k, 1.0);
+            A.set(k, c.n1, 1.0);
+        }
+        if (c.n2 != -1) {
+            A.set(c.n2, k, -1.0);
+            A.set(k, c.n2, -1.0);
+        }
+    };
+    for (size_t i = 0; i < t.resistors.size(); ++i) stamp(t.resistors[i], values.conductance(i));
+    for (size_t i = 0; i < t.capacitors.size(); ++i) stamp(t.capacitors[i], values.capacitance(i) * (1.0 / h));
+    for (int i : t.shuntNodes) A.add(i, i, t.shuntConductance);
+    for (size_t i = 0; i < t.voltageSources.size(); ++i) stampBranch(t.voltageSources[i], t.n + i);
+    for (size_t i = 0; i < t.inductors.size(); ++i) {
+        int k = t.n + t.voltageSources.size() + i;
+        stampBranch(t.inductors[i], k);
+        A.add(k, k, values.inductance(i) * (-1.0 / h));
+    }
+}
+
+// Right-hand side for step h, added to a zeroed b, from the capacitor voltages
+// values.capVoltage(i) and inductor currents values.indCurrent(i) at the end
+// of the previous step. V must also support V * V; b.add(i, v) accumulates.
+template <typename Values, typename Vector>
+void stampCompanionRHS(const CompanionTopology& t, double h, const Values& values, Vector& b) {
+    auto inject = [&](const Terminals& c, const auto& i) {
+        if (c.n1 != -1) b.add(c.n1, i);
+        if (c.n2 != -1) b.add(c.n2, -i);
+    };
+    for (size_t i = 0; i < t.currentSources.size(); ++i) inject(t.currentSources[i], values.current(i));
+    for (size_t i = 0; i < t.capacitors.size(); ++i) {
+        inject(t.capacitors[i], values.capacitance(i) * values.capVoltage(i) * (1.0 / h));
+    }
+    for (size_t i = 0; i < t.voltageSources.size(); ++i) b.add(t.n + i, values.voltage(i));
+    for (size_t i = 0; i < t.inductors.size(); ++i) {
+        b.add(t.n + t.voltageSources.size() + i, values.inductance(i) * values.indCurrent(i) * (-1.0 / h));
+    }
+}
@@ -17,6 +17,11 @@ enum DiodeState {
     STATE_REVERSE_ON = 2
 };
 
+enum DiodeModel {
+    MODEL_IDEAL = 0,    // Piecewise linear, solved by switching between states
+    MODEL_SHOCKLEY = 1  // Exponential junction, solved by Newton-Raphson
+};
+
 class Diode : public Component {
 public:
     Diode(const string& name, Node* n1, Node* n2, DiodeType type, double vf, double vz = 0.0);
@@ -31,13 +36,33 @@ public:
     void setBranchIndex(int index);
     int getBranchIndex() const;
 
+    void setModel(DiodeModel model);
+    DiodeModel getModel() const;
+
+    // Shockley current (including breakdown for zeners) and its derivative at v.
+    double evaluateCurrent(double v, double* conductance) const;
+    // SPICE-style junction voltage limiting between Newton iterations.
+    double limitJunctionVoltage(double v_new, double v_old) const;
+    // Rebuilds the companion model (conductance || current source) around v.
+    void linearize(double v);
+
     double getCurrent() override;
     void setCurrent(double c);
     double getVoltage() override;
 
+    // Exponential model parameters
+    double saturationCurrent = 1e-14;
+    double emissionCoefficient = 1.0;
+    double breakdownCurrent = 1e-3;  // Current at v = -zenerVoltage
+
+    // Newton-Raphson linearization point and companion model
+    double junctionVoltage = 0.0;
+    double companionConductance = 0.0;
+    double companionCurrent = 0.0;
 
 private:
     DiodeType diodeType;
+    DiodeModel diodeModel;
     DiodeState currentState;
 public:
     double forwardVoltage;
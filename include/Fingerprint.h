@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Incremental FNV-1a hash over the bit patterns of doubles. Used to tell whether
+// a cached result (operating point, reduced model) still matches the circuit.
+struct Fingerprint {
+    uint64_t value = 1469598103934665603ULL;
+
+    void mix(double x) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        for (int i = 0; i < 8; ++i) {
+            value ^= (bits >> (8 * i)) & 0xff;
+            value *= 1099511628211ULL;
+        }
+    }
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Solves the linear complementarity problem
+//     w = M z + q,   w >= 0,   z >= 0,   w[i] * z[i] = 0
+// with Lemke's complementary pivoting method (covering vector of ones).
+// Returns false if the method ends on a secondary ray or runs out of pivots,
+// in which case z is left empty.
+bool solveLCPLemke(const vector<vector<double>>& M, const vector<double>& q, vector<double>& z);
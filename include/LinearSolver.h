@@ -11,5 +11,102 @@ void display_vec(vector<double> a);
 
 void test_solver();
 
-vector<complex<double>> gaussianElimination(vector<vector<complex<double>>> A, vector<complex<double>> b);
-vector<double> gaussianElimination(vector<vector<double>> A, vector<double> b);
\ No newline at end of file
+// Systems of up to 16 unknowns go to fixed-size kernels on stack arrays. Larger
+// real systems are split into independent islands solved in parallel, or else
+// reordered by reverse Cuthill-McKee and either torn into parallel subdomains
+// or solved as one band matrix, whichever is estimated to be much cheaper than
+// dense elimination.
+vector<complex<double>> gaussianElimination(const vector<vector<complex<double>>>& A, const vector<complex<double>>& b);
+vector<double> gaussianElimination(const vector<vector<double>>& A, const vector<double>& b);
+
+// LU factorization with partial pivoting, kept so one matrix can be solved
+// against many right-hand sides. Row i of LU corresponds to row perm[i] of A.
+struct LUFactorization {
+    vector<vector<double>> LU;
+    vector<int> perm;
+};
+
+LUFactorization luFactorize(vector<vector<double>> A);
+vector<double> luSolve(const LUFactorization& f, const vector<double>& b);
+// Solves A' x = b with the same factorization (adjoint systems)
+vector<double> luSolveTransposed(const LUFactorization& f, const vector<double>& b);
+
+// Reverse Cuthill-McKee ordering of a symmetric adjacency structure: order[k]
+// is the vertex placed k-th. Neighbours end up close in the order, which keeps
+// the matrix of a chain or ladder inside a narrow band.
+vector<int> reverseCuthillMcKee(const vector<vector<int>>& adjacency);
+
+// Band matrix with kl sub- and ku superdiagonals, factored with partial
+// pivoting in O(n * kl * (kl + ku)). Row swaps can widen the upper band to
+// kl + ku, so entry (i, j) is stored at band[i * width() + j - i + kl] for
+// i - kl <= j <= i + kl + ku.
+struct BandLUFactorization {
+    int n = 0;
+    int kl = 0;
+    int ku = 0;
+    vector<double> band;
+    vector<int> pivots; // Row swapped with row k at step k
+
+    int width() const { return 2 * kl + ku + 1; }
+    double& at(int i, int j) { return band[(size_t)i * width() + j - i + kl]; }
+    double at(int i, int j) const { return band[(size_t)i * width() + j - i + kl]; }
+};
+
+// Factors f.band in place. Returns false on a zero pivot (singular matrix).
+bool bandLUFactorize(BandLUFactorization& f);
+vector<double> bandLUSolve(const BandLUFactorization& f, const vector<double>& b);
+
+// Large connected real systems may be torn into subdomains that are factored
+// in parallel and joined through a Schur complement on their interface.
+// Statistics describe the last torn solve; loadBalance is the largest
+// subdomain interior over the mean (1 is perfect).
+struct TearingStatistics {
+    long long solves = 0;
+    int subdomains = 0;
+    int interfaceSize = 0;
+    int unknowns = 0;
+    double loadBalance = 0.0;
+};
+
+// partitions = 0 uses one subdomain per pool thread, 1 disables tearing
+void setTearingPartitions(int partitions);
+TearingStatistics tearingStatistics();
+
+// Pivot order and L+U structure of a complex matrix whose nonzero pattern
+// stays fixed while its values change (e.g. every point of an AC sweep).
+// Computed once by analyzeSparseLU; every numeric factorization then works on
+// a flat value array laid out by the pattern, so nothing is ever n x n.
+// Factor row k (in pivot order) holds L in positions start[k]..diagonal[k]-1
+// and U from diagonal[k] to start[k+1]-1, with columns in pivot order.
+struct SparseLUPattern {
+    int n = 0;
+    vector<int> rowPerm;             // Original row of the k-th pivot
+    vector<int> colPerm;             // Original column of the k-th pivot
+    vector<int> start;
+    vector<int> columns;
+    vector<int> diagonal;
+    vector<pair<int, int>> nonzeros; // The analysed (row, col) entries
+    vector<int> slot;                // Position of nonzeros[e] in the value array
+    double flops = 0.0;              // Multiply-adds of one numeric factorization
+
+    // Fills a zeroed value array from one entry per analysed nonzero, in its order
+    void load(const vector<complex<double>>& entries, vector<complex<double>>& lu) const;
+    // The same, read from a dense matrix
+    void load(const vector<vector<complex<double>>>& A, vector<complex<double>>& lu) const;
+};
+
+// Markowitz ordering with threshold pivoting on representative values, where
+// sample[e] is the value of nonzeros[e]. Each step takes, among the sparsest
+// few columns, the entry within a fraction of its column maximum that creates
+// the least fill.
+SparseLUPattern analyzeSparseLU(int n, const vector<pair<int, int>>& nonzeros, const vector<complex<double>>& sample);
+// Factors lu (filled by load) in place over the pattern. Returns false if the
+// fixed order meets a zero pivot or a multiplier above 1e3, in which case the
+// caller should fall back to gaussianElimination.
+bool sparseLUFactor(const SparseLUPattern& pattern, vector<complex<double>>& lu);
+// Solves A x = b with the factors of a successful sparseLUFactor
+void sparseLUSolveFactored(const SparseLUPattern& pattern, const vector<complex<double>>& lu, const vector<complex<double>>& b, vector<complex<double>>& x);
+// sparseLUFactor followed by sparseLUSolveFactored
+bool sparseLUSolve(const SparseLUPattern& pattern, vector<complex<double>>& lu, const vector<complex<double>>& b, vector<complex<double>>& x);
+// Solves A' x = b (plain transpose, no conjugation) with the same factors
+void sparseLUSolveTransposed(const SparseLUPattern& pattern, const vector<complex<double>>& lu, const vector<complex<double>>& b, vector<complex<double>>& x);
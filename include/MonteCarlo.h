@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+using namespace std;
+
+enum class VariationDistribution {
+    UNIFORM,  // value * (1 + u), u uniform in [-tolerance, tolerance]
+    GAUSSIAN  // value * (1 + g), g normal with sigma = tolerance / 3
+};
+
+// Relative tolerance on one resistor, capacitor or inductor value (0.05 = 5%)
+struct ComponentVariation {
+    string component;
+    VariationDistribution distribution;
+    double tolerance;
+};
+
+// Statistics of one output over all trials, accumulated as the trials finish
+// rather than from stored waveforms. One entry per axis point.
+struct MonteCarloStatistics {
+    string output;
+    vector<double> mean;
+    vector<double> stddev;
+    vector<double> minimum;
+    vector<double> maximum;
+
+    // Distribution of the value at the last axis point
+    double histogramMin = 0.0;
+    double histogramMax = 0.0;
+    vector<int> histogram;
+};
+
+struct MonteCarloResult {
+    vector<double> axis; // DC: {0}, transient: times, AC: frequencies
+    vector<MonteCarloStatistics> outputs;
+    int completedTrials = 0;
+    int failedTrials = 0; // Trials with a non-finite output
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// One .step dimension: the value of a resistor, capacitor, inductor, DC
+// voltage or current source, or the magnitude of an AC source
+struct StepParameter {
+    string component;
+    vector<double> values;
+};
+
+// Every output as one dense row-major array of shape
+// [values of parameter 0, ..., values of parameter k-1, axis points], so the
+// last parameter and then the axis vary fastest. Failed points hold NaN.
+struct ParameterSweepResult {
+    vector<StepParameter> parameters;
+    vector<double> axis; // DC: {0}, transient: times, AC: frequencies
+    vector<size_t> shape;
+    vector<string> outputs;
+    vector<vector<double>> values; // One array per output
+    int failedPoints = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+struct ACSystemParts;
+
+// Reduced-order AC model. The MNA system G + jwC + Gamma/(jw) is projected by
+// congruence onto a real orthonormal basis V (n x q) of rational Krylov vectors
+// taken at a few expansion frequencies. Each frequency then costs a q x q solve
+// plus the lift x = V y, instead of a full n x n factorization.
+class ReducedACModel {
+public:
+    vector<string> unknownNames;
+    vector<double> expansionFrequencies;
+    vector<vector<double>> basis;               // V, one row per unknown
+    vector<vector<double>> Gr, Cr, Gammar;      // V' G V, V' C V, V' Gamma V
+    vector<complex<double>> br;                 // V' b
+    double minFrequency = 0.0;                  // Range the model was trained on
+    double maxFrequency = 0.0;
+    double errorEstimate = 0.0;                 // Largest relative residual over the training grid
+    uint64_t fingerprint = 0;                   // acSystemFingerprint of the full system
+
+    bool empty() const;
+    size_t order() const;
+    bool covers(double fmin, double fmax) const;
+
+    // Full-size solution estimate at one frequency
+    bool evaluate(double frequency, vector<complex<double>>& x) const;
+
+    bool save(const string& path) const;
+    bool load(const string& path);
+};
+
+// Hash of the full AC system, used to tell whether a saved model still applies
+uint64_t acSystemFingerprint(const ACSystemParts& parts, const vector<complex<double>>& rhs);
+
+// ||b - A(w) x|| / ||b|| for a candidate solution x of the full system
+double acRelativeResidual(const ACSystemParts& parts, const vector<complex<double>>& rhs, double frequency, const vector<complex<double>>& x);
+
+// Builds the model over [fmin, fmax]. Starts from one expansion point at the
+// geometric centre and keeps adding one where the residual over a training grid
+// is worst, until it drops below tolerance or the expansion limit is reached.
+bool buildReducedACModel(const ACSystemParts& parts, const vector<complex<double>>& rhs, double fmin, double fmax,
+                         ReducedACModel& model, double tolerance = 1e-6);
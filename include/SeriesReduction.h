@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <utility>
+#include "export.h"
+
+using namespace std;
+
+// Series/parallel reduction of a linear MNA system whose first `nodes`
+// unknowns are node voltages. Parallel R, L and C already share one matrix
+// entry; a node with at most two neighbours is an internal node of a series
+// chain, and eliminating it folds the chain into one entry between its ends
+// (with any shunt at the node carried along), so series-parallel subnetworks
+// collapse completely. The elimination order is found once per nonzero
+// pattern and replayed on the values of every solve; the eliminated rows
+// stay in the caller's matrix as the map that reconstructs their voltages.
+struct SeriesReduction {
+    int unknowns = 0;
+    int reduced = 0;
+    vector<int> order;              // Eliminated unknowns, in elimination order
+    vector<vector<int>> neighbours; // Their neighbours when eliminated
+    vector<int> kept;               // Remaining unknowns in their original order
+    vector<pair<int, int>> nonzeros; // Pattern of the reduced system
+
+    // False when no node qualifies
+    bool build(const vector<pair<int, int>>& nonzeros, int unknowns, int nodes);
+
+    // Eliminates in place in A and b and writes the reduced system. Returns
+    // false, leaving A and b partly reduced, when a pivot is too small next to
+    // its row, e.g. a series LC chain close to resonance.
+    bool reduce(vector<vector<double>>& A, vector<double>& b,
+                vector<vector<double>>& A_reduced, vector<double>& b_reduced) const;
+    bool reduce(vector<vector<complex<double>>>& A, vector<complex<double>>& b,
+                vector<vector<complex<double>>>& A_reduced, vector<complex<double>>& b_reduced) const;
+
+    // Full solution from the reduced one, with A and b as reduce left them
+    vector<double> expand(const vector<vector<double>>& A, const vector<double>& b, const vector<double>& y) const;
+    vector<complex<double>> expand(const vector<vector<complex<double>>>& A, const vector<complex<double>>& b,
+                                   const vector<complex<double>>& y) const;
+};
+
+// Off by default; applies to DC, transient and AC solves
+CIRCUITSIMULATOR_API void setSeriesReduction(bool enabled);
+CIRCUITSIMULATOR_API bool seriesReductionEnabled();
+
+// Solves through the series reduction when it is enabled and applies.
+// solved, if given, receives the size of the system actually eliminated.
+vector<double> solveSeriesReduced(const vector<vector<double>>& A, const vector<double>& b, int nodes, int* solved = nullptr);
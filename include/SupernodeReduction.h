@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include "export.h"
+
+using namespace std;
+
+// Supernode reduction of a DC/transient MNA system whose first `nodes`
+// unknowns are node voltages. A branch whose row only fixes the difference of
+// two node voltages (a voltage source, a conducting ideal diode, an inductor at
+// the DC step where L/dt vanishes) is eliminated with its current: its nodes
+// collapse into one supernode whose KCL rows are summed, and a supernode that
+// reaches ground has its voltages fixed outright. Branches are found from the
+// matrix structure, so the same reduction holds while only values change.
+struct SupernodeReduction {
+    int unknowns = 0;  // Size of the full system
+    int reduced = 0;   // Size of the reduced system
+    int reducedNodes = 0; // Supernodes not tied to ground, first in the reduced system
+    int nodes = 0;
+
+    // Per full unknown: reduced unknown it maps to, or -1 (fixed node or eliminated current)
+    vector<int> column;
+    // Per reduced unknown: full rows summed into it
+    vector<vector<int>> rows;
+    // Eliminated branches as tree edges: the current of branch `branch` is
+    // recovered from the KCL row of `child`, whose voltage is that of `parent`
+    // plus sign * rhs[branch]. Parents come before their children.
+    struct Edge {
+        int child;
+        int parent; // A node, or -1 for ground
+        int branch;
+        double sign;
+    };
+    vector<Edge> edges;
+
+    // False when no branch can be eliminated, or when constraint branches form
+    // a loop (the full system is singular then and is left as it is)
+    bool build(const vector<vector<double>>& A, int nodes);
+
+    void reduce(const vector<vector<double>>& A, const vector<double>& b,
+                vector<vector<double>>& A_reduced, vector<double>& b_reduced) const;
+    vector<double> expand(const vector<vector<double>>& A, const vector<double>& b, const vector<double>& y) const;
+
+private:
+    vector<double> offsets(const vector<double>& b) const;
+};
+
+// Solves the MNA system through its supernode reduction when there is one,
+// then through the series reduction when that is enabled
+CIRCUITSIMULATOR_API vector<double> solveMNA(const vector<vector<double>>& A, const vector<double>& b, int nodes);
+
+// Unknowns left by each reduction solveMNA applies to the system
+struct MNAReductionSizes {
+    int unknowns = 0;
+    int supernodes = 0;
+    int series = 0;
+};
+
+// Sizes of the last solveMNA on the calling thread
+MNAReductionSizes lastMNAReductionSizes();
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// Fixed set of worker threads fed from a shared task queue. Analyses share one
+// process-wide pool through shared() so sweeps do not pay thread start-up.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads = 0); // 0 = one per hardware thread
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const;
+    void enqueue(function<void()> task);
+
+    // Splits [0, count) into contiguous chunks, runs body(begin, end) for each
+    // chunk on the workers and returns when all chunks are done. The first
+    // exception thrown by a chunk is rethrown here. Runs inline when called from a
+    // worker thread or when there is nothing to split.
+    void parallelFor(size_t count, const function<void(size_t, size_t)>& body);
+
+    // Like parallelFor, but for iterations of uneven cost: [0, count) is cut into
+    // fixed blocks of grain iterations that idle workers claim one at a time, so
+    // a slow block never holds up a whole static chunk. Block boundaries do not
+    // depend on the number of threads.
+    void parallelForDynamic(size_t count, size_t grain, const function<void(size_t, size_t)>& body);
+
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable queueCondition;
+    bool stopping;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "export.h"
+
+using namespace std;
+
+enum class TopologyIssueType {
+    FLOATING_NODES, // Nodes with no conducting path to ground
+    VOLTAGE_LOOP,   // Voltage sources (and, in DC, inductors) closing a loop
+    CURRENT_CUTSET  // Floating nodes fed by current sources, whose voltage would be I/gmin
+};
+
+struct TopologyIssue {
+    TopologyIssueType type;
+    vector<string> nodes;    // The floating group, for FLOATING_NODES and CURRENT_CUTSET
+    vector<string> elements; // The loop, or the current sources crossing the cutset
+    bool fixed = false;      // Tied to ground through the shunt instead of rejected
+    string describe() const;
+};
+
+// Result of the graph check run before every DC, transient and AC assembly
+struct TopologyReport {
+    vector<TopologyIssue> issues;
+    vector<int> shuntNodes;         // Matrix indices of the nodes tied to ground
+    double shuntConductance = 1e-12;
+    bool rejected = false;
+
+    // One line per issue
+    string describe() const;
+};
+
+// What the check does with a group of nodes that has no path to ground
+enum class FloatingNodePolicy {
+    ADD_GMIN, // Ties its first node to ground through the shunt conductance
+    REJECT
+};
+
+// ADD_GMIN by default; loops and cutsets are rejected, except that the DC
+// point a transient starts from ties DC-only cutsets to ground
+CIRCUITSIMULATOR_API void setFloatingNodePolicy(FloatingNodePolicy policy);
+CIRCUITSIMULATOR_API FloatingNodePolicy floatingNodePolicy();
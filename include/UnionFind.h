@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <numeric>
+#include <utility>
+
+using namespace std;
+
+// Disjoint sets over 0..n-1 with path halving and union by size
+struct UnionFind {
+    vector<int> parent;
+    vector<int> size;
+
+    explicit UnionFind(int n) : parent(n), size(n, 1) {
+        iota(parent.begin(), parent.end(), 0);
+    }
+
+    int find(int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    // Returns false when a and b were already in the same set
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (size[a] < size[b]) swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        return true;
+    }
+};
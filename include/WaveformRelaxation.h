@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Analysis.h"
+#include "export.h"
+
+// How the partitions of one relaxation sweep see each other's waveforms
+enum class RelaxationType {
+    JACOBI,      // Every partition reads the previous sweep; partitions run in parallel
+    GAUSS_SEIDEL // Partitions run in order and read the waveforms already updated this sweep
+};
+
+// Transient by waveform relaxation. Nodes joined by a capacitor, inductor or
+// source, or by a resistor that is not weak next to the rest of their
+// conductance, share a partition; the weak resistors left between partitions
+// are the only coupling. Each partition integrates a window of windowSteps
+// output steps on its own, with backward Euler steps of t_step * 2^k chosen by
+// its local truncation error, reading the other partitions' node voltages from
+// their last waveforms. Sweeps repeat until no interface waveform moves by more
+// than tolerance, then the next window starts from the converged states.
+// With latencyBypass, a partition at rest whose inputs hold still over the
+// window skips integration and keeps its voltages for that sweep; it is
+// integrated again as soon as a neighbour moves.
+struct WaveformRelaxationOptions {
+    double t_step = 0.0;
+    double t_stop = 0.0;
+    RelaxationType relaxation = RelaxationType::JACOBI;
+    int windowSteps = 50;
+    int maxIterations = 50;      // Sweeps per window
+    double tolerance = 1e-6;     // Largest interface voltage change of a converged sweep (V)
+    double stepTolerance = 1e-4; // Largest local truncation error of a node voltage per step (V)
+    int maxStepLevel = 6;        // Local steps run from t_step up to t_step * 2^maxStepLevel
+    double couplingRatio = 0.1;  // A resistor is weak below this fraction of the other conductance at both ends
+    int maxPartitions = 0;       // Packs the blocks into at most this many partitions; 0 keeps every block
+    bool latencyBypass = true;
+    double latencyTolerance = 1e-6; // Drift over a window still counted as at rest (V)
+    bool compareMonolithic = false;
+};
+
+struct WaveformRelaxationResult {
+    int partitions = 0;
+    int windows = 0;
+    int iterations = 0;            // Sweeps over all windows
+    int unconvergedWindows = 0;
+    vector<int> partitionNodes;    // Node count of each partition
+    vector<long long> partitionSteps; // Local steps each partition took in the accepted sweeps
+    long long deviceEvaluations = 0;   // Component stamps of every local solve
+    long long bypassedEvaluations = 0; // Stamps latent partitions skipped, one per component and output step
+    double maxDeviation = -1.0;    // Largest node voltage difference from transientAnalysis, when compared
+};
+
+// Fills the node and voltage source histories as transientAnalysis does.
+// Circuits with diodes run the monolithic transient instead (partitions = 0).
+CIRCUITSIMULATOR_API bool waveformRelaxationAnalysis(Circuit& circuit, const WaveformRelaxationOptions& options,
+                                                     WaveformRelaxationResult& result);
@@ -0,0 +1,87 @@
+#include "ACSweepResult.h"
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void ACSweepResult::reset(const vector<string>& names, const vector<double>& freqs) {
+    unknownNames = names;
+    frequencies = freqs;
+    values.assign(names.size() * freqs.size(), complex<double>(numeric_limits<double>::quiet_NaN(), 0.0));
+}
+
+void ACSweepResult::clear() {
+    unknownNames.clear();
+    frequencies.clear();
+    values.clear();
+}
+
+size_t ACSweepResult::pointCount() const {
+    return frequencies.size();
+}
+
+size_t ACSweepResult::unknownCount() const {
+    return unknownNames.size();
+}
+
+int ACSweepResult::findUnknown(const string& name) const {
+    for (size_t k = 0; k < unknownNames.size(); ++k) {
+        if (unknownNames[k] == name) return static_cast<int>(k);
+    }
+    return -1;
+}
+
+complex<double>* ACSweepResult::column(int k) {
+    return values.data() + static_cast<size_t>(k) * frequencies.size();
+}
+
+const complex<double>* ACSweepResult::column(int k) const {
+    return values.data() + static_cast<size_t>(k) * frequencies.size();
+}
+
+vector<double> ACSweepResult::derive(const complex<double>* data, ACQuantity quantity) const {
+    size_t count = frequencies.size();
+    vector<double> result(count);
+
+    if (quantity == AC_MAGNITUDE || quantity == AC_MAGNITUDE_DB) {
+        for (size_t i = 0; i < count; ++i) {
+            double magnitude = abs(data[i]);
+            result[i] = (quantity == AC_MAGNITUDE) ? magnitude : 20.0 * log10(magnitude);
+        }
+        return result;
+    }
+
+    // Phase in radians, unwrapped so consecutive points differ by less than pi
+    vector<double> phase(count);
+    for (size_t i = 0; i < count; ++i) {
+        phase[i] = arg(data[i]);
+        if (i > 0) {
+            while (phase[i] - phase[i - 1] > M_PI) phase[i] -= 2.0 * M_PI;
+            while (phase[i] - phase[i - 1] < -M_PI) phase[i] += 2.0 * M_PI;
+        }
+    }
+
+    if (quantity == AC_PHASE) {
+        for (size_t i = 0; i < count; ++i) {
+            result[i] = phase[i] * 180.0 / M_PI;
+        }
+        return result;
+    }
+
+    // Group delay by central differences, one-sided at the ends
+    for (size_t i = 0; i < count; ++i) {
+        if (count < 2) {
+            result[i] = 0.0;
+            continue;
+        }
+        size_t lo = (i == 0) ? 0 : i - 1;
+        size_t hi = (i + 1 == count) ? i : i + 1;
+        double d_omega = 2.0 * M_PI * (frequencies[hi] - frequencies[lo]);
+        result[i] = (d_omega != 0.0) ? -(phase[hi] - phase[lo]) / d_omega : 0.0;
+    }
+    return result;
+}
@@ -1,129 +1,517 @@
 #include "Analysis.h"
 #include "LinearSolver.h"
+#include "LCPSolver.h"
+#include "ThreadPool.h"
+#include "ReducedOrderModel.h"
+#include "SupernodeReduction.h"
+#include "SeriesReduction.h"
 #include "Node.h"
 #include <iostream>
 #include <vector>
 #include <iomanip>
 #include <cmath>
 #include <complex>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <atomic>
 
 using namespace std;
 
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
 void result_from_vec(Circuit& circuit, const vector<double>& solvedVoltages, const vector<Node*>& nonGroundNodes);
 
-void dcAnalysis(Circuit& circuit) {
-    cout << "// Performing DC Analysis..." << endl;
-    circuit.setDeltaT(1e12);
-    vector<Node*> nonGroundNodes;
-    for (auto* node : circuit.nodes) {
-        if (!node->isGround) {
-            nonGroundNodes.push_back(node);
+// Re-evaluates every diode against its switching conditions using the latest
+// solution. Returns true if any diode changed state.
+static bool updateDiodeStates(Circuit& circuit, double epsilon) {
+    bool changed = false;
+    for (auto& current_diode : circuit.diodes) {
+        if (current_diode.getModel() != MODEL_IDEAL) continue;
+        DiodeState old_state = current_diode.getState();
+        DiodeState new_state = old_state;
+
+        double v_anode = current_diode.node1->getVoltage();
+        double v_cathode = current_diode.node2->getVoltage();
+        double v_diode_across = v_anode - v_cathode;
+
+        if (current_diode.getDiodeType() == NORMAL) {
+            if (old_state == STATE_OFF) {
+                if (v_diode_across >= current_diode.getForwardVoltage() - epsilon) {
+                    new_state = STATE_FORWARD_ON;
+                }
+            } else if (old_state == STATE_FORWARD_ON) {
+                if (current_diode.getCurrent() < -epsilon) {
+                    new_state = STATE_OFF;
+                }
+            }
+        } else if (current_diode.getDiodeType() == ZENER) {
+            if (old_state == STATE_OFF) {
+                if (v_diode_across >= current_diode.getForwardVoltage() - epsilon) {
+                    new_state = STATE_FORWARD_ON;
+                } else if (v_diode_across <= -current_diode.getZenerVoltage() + epsilon) {
+                    new_state = STATE_REVERSE_ON;
+                }
+            } else if (old_state == STATE_FORWARD_ON) {
+                if (current_diode.getCurrent() < -epsilon) {
+                    new_state = STATE_OFF;
+                }
+            } else if (old_state == STATE_REVERSE_ON) {
+                if (current_diode.getCurrent() > epsilon) {
+                    new_state = STATE_OFF;
+                }
+            }
+        }
+
+        if (new_state != old_state) {
+            changed = true;
+            current_diode.setState(new_state);
         }
     }
+    return changed;
+}
 
-    const int MAX_DIODE_ITERATIONS = 100;
-    bool converged = false;
-    int iteration_count = 0;
-    const double EPSILON_CURRENT = 1e-9;
+// One damped Newton-Raphson update for exponential diodes. The junction voltage
+// from the latest solution is limited against the previous linearization point
+// and the companion model is rebuilt around it. Returns true while either the
+// voltage update or the current residual of any diode is outside tolerance.
+static bool updateDiodeLinearization(Circuit& circuit) {
+    const double RELTOL = 1e-3;
+    const double VNTOL = 1e-6;
+    const double ABSTOL = 1e-12;
+
+    bool pending = false;
     for (auto& diode : circuit.diodes) {
-        diode.setState(STATE_OFF);
+        if (diode.getModel() != MODEL_SHOCKLEY) continue;
+
+        double v_solved = diode.node1->getVoltage() - diode.node2->getVoltage();
+        double v_old = diode.junctionVoltage;
+        double v_new = diode.limitJunctionVoltage(v_solved, v_old);
+
+        if (fabs(v_new - v_old) > VNTOL + RELTOL * max(fabs(v_new), fabs(v_old))) {
+            pending = true;
+        } else {
+            // Current through the linearized branch vs. the true junction current.
+            double i_companion = diode.companionConductance * v_solved + diode.companionCurrent;
+            double i_true = diode.evaluateCurrent(v_solved, nullptr);
+            if (fabs(i_true - i_companion) > ABSTOL + RELTOL * max(fabs(i_true), fabs(i_companion))) {
+                pending = true;
+            }
+        }
+        diode.linearize(v_new);
+    }
+    return pending;
+}
+
+// Signed distance of a diode from its next switching boundary, evaluated on the
+// latest solution. Negative while the present state is consistent; crosses zero
+// at the instant the diode wants to change state.
+static double diodeSwitchingMargin(Diode& diode) {
+    // Exponential diodes change conduction smoothly and never produce events.
+    if (diode.getModel() != MODEL_IDEAL) return -numeric_limits<double>::infinity();
+
+    double v_diode_across = diode.node1->getVoltage() - diode.node2->getVoltage();
+    switch (diode.getState()) {
+        case STATE_FORWARD_ON:
+            return -diode.getCurrent();
+        case STATE_REVERSE_ON:
+            return diode.getCurrent();
+        case STATE_OFF:
+        default: {
+            double margin = v_diode_across - diode.getForwardVoltage();
+            if (diode.getDiodeType() == ZENER) {
+                margin = max(margin, -diode.getZenerVoltage() - v_diode_across);
+            }
+            return margin;
+        }
+    }
+}
+
+// Poses the ideal diodes as a linear complementarity problem over the Schur
+// complement of the remaining linear network (every ideal diode open) and
+// assigns their states from Lemke's solution. Each diode contributes a forward
+// branch, zeners also a reverse branch:
+//     w = V - P'x >= 0,  z >= 0,  w'z = 0,  x = A^-1 (b - P z)
+// so M = P' A^-1 P and q = V - P' A^-1 b. Returns false if Lemke fails.
+static bool assignDiodeStatesLCP(Circuit& circuit, AnalysisType type) {
+    const double GMIN = 1e-12;
+    const double EPSILON_CURRENT = 1e-9;
+
+    struct IdealBranch {
+        Diode* diode;
+        DiodeState state;
+        double sign;      // +1 forward (anode -> cathode), -1 reverse breakdown
+        double threshold; // Forward or zener voltage
+        int anode_index;
+        int cathode_index;
+    };
+    vector<IdealBranch> branches;
+    for (auto& d : circuit.diodes) {
+        if (d.getModel() != MODEL_IDEAL) continue;
+        d.setState(STATE_OFF);
+        int a = circuit.getNodeMatrixIndex(d.node1);
+        int c = circuit.getNodeMatrixIndex(d.node2);
+        branches.push_back({&d, STATE_FORWARD_ON, 1.0, d.getForwardVoltage(), a, c});
+        if (d.getDiodeType() == ZENER) {
+            branches.push_back({&d, STATE_REVERSE_ON, -1.0, d.getZenerVoltage(), a, c});
+        }
+    }
+    if (branches.empty()) return true;
+
+    circuit.assignDiodeBranchIndices();
+    circuit.set_MNA_A(type);
+    circuit.set_MNA_RHS(type);
+    if (circuit.MNA_A.empty() || circuit.MNA_A.size() != circuit.MNA_RHS.size()) return false;
+
+    // Nodes reached only through diodes float once the diodes are opened.
+    vector<vector<double>> A = circuit.MNA_A;
+    int n = circuit.countNonGroundNodes();
+    for (int i = 0; i < n; i++) {
+        A[i][i] += GMIN;
+    }
+    LUFactorization lu = luFactorize(A);
+    vector<double> x0 = luSolve(lu, circuit.MNA_RHS);
+
+    auto branchVoltage = [](const IdealBranch& br, const vector<double>& x) {
+        double va = br.anode_index != -1 ? x[br.anode_index] : 0.0;
+        double vc = br.cathode_index != -1 ? x[br.cathode_index] : 0.0;
+        return br.sign * (va - vc);
+    };
+
+    size_t m = branches.size();
+    vector<vector<double>> M(m, vector<double>(m, 0.0));
+    vector<double> q(m);
+    for (size_t j = 0; j < m; j++) {
+        vector<double> p(A.size(), 0.0);
+        if (branches[j].anode_index != -1) p[branches[j].anode_index] += branches[j].sign;
+        if (branches[j].cathode_index != -1) p[branches[j].cathode_index] -= branches[j].sign;
+        vector<double> response = luSolve(lu, p);
+        for (size_t i = 0; i < m; i++) {
+            M[i][j] = branchVoltage(branches[i], response);
+        }
+        q[j] = branches[j].threshold - branchVoltage(branches[j], x0);
+    }
+
+    vector<double> z;
+    if (!solveLCPLemke(M, q, z)) return false;
+
+    for (size_t j = 0; j < m; j++) {
+        if (z[j] > EPSILON_CURRENT) {
+            branches[j].diode->setState(branches[j].state);
+        }
+    }
+    return true;
+}
+
+// Solves a single backward Euler step of length h with every diode held in its
+// present state. The companion history (prevVoltage/prevCurrent) is untouched,
+// so the step can be retried with a different h.
+static bool solveFrozenTransientStep(Circuit& circuit, double h, const vector<Node*>& nonGroundNodes) {
+    circuit.setDeltaT(h);
+    circuit.assignDiodeBranchIndices();
+    circuit.set_MNA_A(AnalysisType::TRANSIENT);
+    circuit.set_MNA_RHS(AnalysisType::TRANSIENT);
+    try {
+        result_from_vec(circuit, solveMNA(circuit.MNA_A, circuit.MNA_RHS, nonGroundNodes.size()), nonGroundNodes);
+    } catch (const exception& e) {
+        analysisErrors() << "Error during Gaussian Elimination: " << e.what() << endl;
+        return false;
+    }
+    return true;
+}
+
+// Brackets the earliest diode switching instant inside (0, h] and refines it by
+// regula falsi with a bisection safeguard. Diode states must hold the values that
+// were consistent at the start of the step, and start_margins the matching
+// diodeSwitchingMargin() values. Returns the step length up to the event, or h
+// when no diode crosses its boundary within the step.
+static double locateDiodeEvent(Circuit& circuit, double h, const vector<double>& start_margins,
+                               const vector<Node*>& nonGroundNodes, double epsilon) {
+    const int MAX_EVENT_ITERATIONS = 40;
+    const double EVENT_TIME_TOLERANCE = 1e-9 * h;
+
+    if (!solveFrozenTransientStep(circuit, h, nonGroundNodes)) return h;
+
+    vector<double> lo_margins = start_margins;
+    double h_lo = 0.0;
+    double h_hi = h;
+
+    // Picks the diode whose linearly interpolated crossing comes first.
+    auto earliestCrossing = [&]() {
+        int index = -1;
+        double best_fraction = 0.0;
+        for (size_t i = 0; i < circuit.diodes.size(); ++i) {
+            if (lo_margins[i] >= -epsilon) continue;
+            double g = diodeSwitchingMargin(circuit.diodes[i]);
+            if (g <= epsilon) continue;
+            double fraction_after = g / (g - lo_margins[i]);
+            if (index == -1 || fraction_after > best_fraction) {
+                index = static_cast<int>(i);
+                best_fraction = fraction_after;
+            }
+        }
+        return index;
+    };
+
+    int event_diode = earliestCrossing();
+    if (event_diode == -1) return h;
+    double g_hi = diodeSwitchingMargin(circuit.diodes[event_diode]);
+
+    for (int iter = 0; iter < MAX_EVENT_ITERATIONS && h_hi - h_lo > EVENT_TIME_TOLERANCE; ++iter) {
+        double g_lo = lo_margins[event_diode];
+        double width = h_hi - h_lo;
+        double h_mid = h_lo + width * (-g_lo) / (g_hi - g_lo);
+        if (!(h_mid > h_lo + 0.1 * width && h_mid < h_hi - 0.1 * width)) {
+            h_mid = h_lo + 0.5 * width;
+        }
+
+        if (!solveFrozenTransientStep(circuit, h_mid, nonGroundNodes)) break;
+
+        int crossing = earliestCrossing();
+        if (crossing != -1) {
+            event_diode = crossing;
+            h_hi = h_mid;
+            g_hi = diodeSwitchingMargin(circuit.diodes[event_diode]);
+        } else {
+            h_lo = h_mid;
+            for (size_t i = 0; i < circuit.diodes.size(); ++i) {
+                lo_margins[i] = diodeSwitchingMargin(circuit.diodes[i]);
+            }
+        }
     }
+    return h_hi;
+}
 
-    // Create a copy of the MNA_A matrix for reuse
-    vector<vector<double>> a_matrix_copy;
+
+// Runs the nonlinear loop (ideal diode states and exponential diode Newton
+// updates) starting from whatever states the diodes currently hold. Returns
+// false if it runs out of iterations or the solution is not finite; every solve
+// is added to iteration_count.
+static bool solveDCOperatingPoint(Circuit& circuit, const vector<Node*>& nonGroundNodes, int& iteration_count) {
+    const int MAX_DIODE_ITERATIONS = 100;
+    const double EPSILON_CURRENT = 1e-9;
+    bool converged = false;
+    int local_iterations = 0;
 
     do {
         converged = true;
         iteration_count++;
-
-        vector<DiodeState> previous_diode_states;
-        for (const auto& diode : circuit.diodes) {
-            previous_diode_states.push_back(diode.getState());
-        }
+        local_iterations++;
 
         circuit.assignDiodeBranchIndices();
         circuit.set_MNA_A(AnalysisType::DC);
         circuit.set_MNA_RHS(AnalysisType::DC);
 
         if (circuit.MNA_A.empty() || circuit.MNA_A[0].empty() || circuit.MNA_RHS.empty() || circuit.MNA_A.size() != circuit.MNA_RHS.size()) {
-            cout << "// No solvable MNA system for the current circuit state." << endl;
+            analysisOutput() << "// No solvable MNA system for the current circuit state." << endl;
             break;
         }
 
-        // Save a copy of the A matrix for later reuse in sweeps
-        if (a_matrix_copy.empty()) {
-            a_matrix_copy = circuit.MNA_A;
-        }
-
         vector<double> solved_solution;
         try {
-            solved_solution = gaussianElimination(circuit.MNA_A, circuit.MNA_RHS);
+            solved_solution = solveMNA(circuit.MNA_A, circuit.MNA_RHS, nonGroundNodes.size());
         } catch (const exception& e) {
-            cerr << "Error during Gaussian Elimination: " << e.what() << endl;
-            converged = false;
-            break;
+            analysisErrors() << "Error during Gaussian Elimination: " << e.what() << endl;
+            return false;
+        }
+        for (double value : solved_solution) {
+            if (!isfinite(value)) return false;
         }
 
         result_from_vec(circuit, solved_solution, nonGroundNodes);
+        circuit.MNA_solution = move(solved_solution);
 
-        for (size_t i = 0; i < circuit.diodes.size(); ++i) {
-            Diode& current_diode = circuit.diodes[i];
-            DiodeState old_state = previous_diode_states[i];
-
-            double v_anode = current_diode.node1->getVoltage();
-            double v_cathode = current_diode.node2->getVoltage();
-            double v_diode_across = v_anode - v_cathode;
-            DiodeState new_state = old_state;
-
-            if (current_diode.getDiodeType() == NORMAL) {
-                if (old_state == STATE_OFF) {
-                    if (v_diode_across >= current_diode.getForwardVoltage() - EPSILON_CURRENT) {
-                        new_state = STATE_FORWARD_ON;
-                    }
-                } else if (old_state == STATE_FORWARD_ON) {
-                    if (current_diode.getCurrent() < -EPSILON_CURRENT) {
-                        new_state = STATE_OFF;
-                    }
-                }
-            } else if (current_diode.getDiodeType() == ZENER) {
-                if (old_state == STATE_OFF) {
-                    if (v_diode_across >= current_diode.getForwardVoltage() - EPSILON_CURRENT) {
-                        new_state = STATE_FORWARD_ON;
-                    } else if (v_diode_across <= -current_diode.getZenerVoltage() + EPSILON_CURRENT) {
-                        new_state = STATE_REVERSE_ON;
-                    }
-                } else if (old_state == STATE_FORWARD_ON) {
-                    if (current_diode.getCurrent() < -EPSILON_CURRENT) {
-                        new_state = STATE_OFF;
-                    }
-                } else if (old_state == STATE_REVERSE_ON) {
-                    if (current_diode.getCurrent() > EPSILON_CURRENT) {
-                        new_state = STATE_OFF;
-                    }
-                }
+        if (updateDiodeStates(circuit, EPSILON_CURRENT)) {
+            converged = false;
+        }
+        if (updateDiodeLinearization(circuit)) {
+            converged = false;
+        }
+
+    } while (!converged && local_iterations < MAX_DIODE_ITERATIONS);
+
+    return converged;
+}
+
+// Reports the last torn solve if any happened since `before` was taken
+static void reportTearing(const TearingStatistics& before) {
+    TearingStatistics after = tearingStatistics();
+    if (after.solves == before.solves) return;
+    analysisOutput() << "// Tearing: " << after.solves - before.solves << " solve(s) over " << after.subdomains
+                     << " subdomains, interface " << after.interfaceSize << " of " << after.unknowns
+                     << " unknowns, load balance " << after.loadBalance << "." << endl;
+}
+
+// Runs the topology check and reports its issues. A rejected circuit gets NaN
+// node voltages, so callers sampling them see the failure.
+static bool checkTopologyBeforeAssembly(Circuit& circuit, AnalysisType type, bool tieAllFloating = false) {
+    circuit.topology = checkTopology(circuit, type, tieAllFloating);
+    for (const auto& issue : circuit.topology.issues) {
+        analysisErrors() << (issue.fixed ? "Warning: " : "Error: ") << issue.describe() << endl;
+    }
+    if (!circuit.topology.rejected) return true;
+    for (auto* node : circuit.nodes) {
+        if (!node->isGround) node->setVoltage(numeric_limits<double>::quiet_NaN());
+    }
+    return false;
+}
+
+static void resetDiodeStates(Circuit& circuit) {
+    for (auto& diode : circuit.diodes) {
+        diode.setState(STATE_OFF);
+        diode.linearize(0.0);
+    }
+}
+
+// Gmin stepping: a large shunt from every node to ground makes the system well
+// conditioned and the diodes easy to place. The shunt is relaxed a decade at a
+// time, each stage starting from the previous operating point, and finally
+// removed.
+static bool gminStepping(Circuit& circuit, const vector<Node*>& nonGroundNodes, int& iteration_count) {
+    const double GMIN_START = 1e-2;
+    const double GMIN_STOP = 1e-12;
+
+    resetDiodeStates(circuit);
+    bool converged = true;
+    for (double g = GMIN_START; g >= GMIN_STOP && converged; g /= 10.0) {
+        circuit.setGmin(g);
+        converged = solveDCOperatingPoint(circuit, nonGroundNodes, iteration_count);
+    }
+    circuit.setGmin(0.0);
+    return converged && solveDCOperatingPoint(circuit, nonGroundNodes, iteration_count);
+}
+
+// Source stepping: every independent source ramps from zero to its full value.
+// The ramp step grows after a converged stage and is halved after a failed one,
+// which restarts from the last converged operating point.
+static bool sourceStepping(Circuit& circuit, const vector<Node*>& nonGroundNodes, int& iteration_count) {
+    const double MIN_SOURCE_STEP = 1e-4;
+
+    resetDiodeStates(circuit);
+    circuit.setSourceScale(0.0);
+    bool converged = solveDCOperatingPoint(circuit, nonGroundNodes, iteration_count);
+
+    double scale = 0.0;
+    double step = 0.1;
+    while (converged && scale < 1.0) {
+        vector<DiodeState> saved_states;
+        vector<double> saved_junctions;
+        for (const auto& diode : circuit.diodes) {
+            saved_states.push_back(diode.getState());
+            saved_junctions.push_back(diode.junctionVoltage);
+        }
+
+        double next_scale = min(1.0, scale + step);
+        circuit.setSourceScale(next_scale);
+        if (solveDCOperatingPoint(circuit, nonGroundNodes, iteration_count)) {
+            scale = next_scale;
+            step = min(step * 2.0, 0.5);
+        } else {
+            for (size_t i = 0; i < circuit.diodes.size(); ++i) {
+                circuit.diodes[i].setState(saved_states[i]);
+                circuit.diodes[i].linearize(saved_junctions[i]);
             }
+            step /= 2.0;
+            converged = step >= MIN_SOURCE_STEP;
+        }
+    }
+    circuit.setSourceScale(1.0);
+    return converged;
+}
+
+// dcAnalysis, or with transientStart the operating point a transient starts
+// from, whose transient graph has already been accepted
+static void solveDC(Circuit& circuit, DiodeSolverType diodeSolver, bool warmStart, bool transientStart) {
+    analysisOutput() << "// Performing DC Analysis..." << endl;
+    TearingStatistics tearing = tearingStatistics();
+    circuit.setDeltaT(1e12);
+    circuit.setGmin(0.0);
+    circuit.setSourceScale(1.0);
+    circuit.MNA_solution.clear();
+    vector<Node*> nonGroundNodes;
+    for (auto* node : circuit.nodes) {
+        if (!node->isGround) {
+            nonGroundNodes.push_back(node);
+        }
+    }
+
+    if (!checkTopologyBeforeAssembly(circuit, AnalysisType::DC, transientStart)) {
+        if (transientStart) {
+            for (auto* node : nonGroundNodes) node->setVoltage(0.0);
+            analysisOutput() << "// DC Analysis skipped: the transient starts from zero node voltages." << endl;
+            return;
+        }
+        analysisOutput() << "// DC Analysis aborted: invalid circuit topology." << endl;
+        return;
+    }
+
+    int iteration_count = 0;
+
+    // A warm start keeps the diode states and Newton linearization of the previous
+    // operating point, so an unchanged circuit confirms in a single solve.
+    if (!warmStart) {
+        resetDiodeStates(circuit);
 
-            if (new_state != old_state) {
-                converged = false;
-                current_diode.setState(new_state);
+        if (diodeSolver == DiodeSolverType::LCP && !assignDiodeStatesLCP(circuit, AnalysisType::DC)) {
+            analysisErrors() << "Warning: LCP diode solver found no state assignment, falling back to relaxation." << endl;
+            for (auto& diode : circuit.diodes) {
+                diode.setState(STATE_OFF);
             }
         }
+    }
 
-    } while (!converged && iteration_count < MAX_DIODE_ITERATIONS);
+    bool converged = solveDCOperatingPoint(circuit, nonGroundNodes, iteration_count);
 
     if (!converged) {
-        cerr << "Warning: DC Analysis did not converge after " << MAX_DIODE_ITERATIONS << " iterations for diodes." << endl;
+        analysisOutput() << "// Direct DC solve failed, trying gmin stepping..." << endl;
+        converged = gminStepping(circuit, nonGroundNodes, iteration_count);
+    }
+    if (!converged) {
+        analysisOutput() << "// Gmin stepping failed, trying source stepping..." << endl;
+        converged = sourceStepping(circuit, nonGroundNodes, iteration_count);
+    }
+
+    if (!converged) {
+        analysisErrors() << "Warning: DC Analysis did not converge after " << iteration_count << " iterations for diodes." << endl;
+    }
+
+    if (!circuit.MNA_A.empty()) {
+        MNAReductionSizes sizes = lastMNAReductionSizes();
+        if (sizes.supernodes < sizes.unknowns) {
+            analysisOutput() << "// Supernode reduction: " << sizes.unknowns << " -> " << sizes.supernodes << " unknowns." << endl;
+        }
+        if (sizes.series < sizes.supernodes) {
+            analysisOutput() << "// Series reduction: " << sizes.supernodes << " -> " << sizes.series << " unknowns." << endl;
+        }
     }
+    reportTearing(tearing);
+    analysisOutput() << "// DC Analysis complete after " << iteration_count << " iteration(s)." << endl;
+}
+
+void dcAnalysis(Circuit& circuit, DiodeSolverType diodeSolver, bool warmStart) {
+    solveDC(circuit, diodeSolver, warmStart, false);
+}
 
-    cout << "// DC Analysis complete." << endl;
+bool transientOperatingPoint(Circuit& circuit, DiodeSolverType diodeSolver) {
+    if (!checkTopologyBeforeAssembly(circuit, AnalysisType::TRANSIENT)) return false;
+    TopologyReport transient = circuit.topology;
+    solveDC(circuit, diodeSolver, false, true);
+    circuit.topology = move(transient);
+    return true;
 }
 
 
-void transientAnalysis(Circuit& circuit, double t_step, double t_stop) {
-    cout << "// Performing Transient Analysis..." << endl;
+void transientAnalysis(Circuit& circuit, double t_step, double t_stop, DiodeSolverType diodeSolver) {
+    analysisOutput() << "// Performing Transient Analysis..." << endl;
     circuit.clearComponentHistory();
 
-    dcAnalysis(circuit);
+    if (!transientOperatingPoint(circuit, diodeSolver)) {
+        analysisOutput() << "// Transient Analysis aborted: invalid circuit topology." << endl;
+        return;
+    }
+    TearingStatistics tearing = tearingStatistics();
 
     for (auto& cap : circuit.capacitors) {
         cap.prevVoltage = 0.0;
@@ -151,101 +539,108 @@ void transientAnalysis(Circuit& circuit, double t_step, double t_stop) {
         vs.addCurrentHistoryPoint(0.0, vs.getCurrent());
     }
 
+    const int MAX_DIODE_ITERATIONS = 100;
+    const int MAX_EVENTS_PER_STEP = 50;
+    const double EPSILON_CURRENT = 1e-9;
+    // Events closer than this to the start of a step are left to the relaxation loop.
+    const double MIN_EVENT_STEP = 1e-6 * t_step;
+    int located_events = 0;
+    bool has_ideal_diodes = any_of(circuit.diodes.begin(), circuit.diodes.end(),
+                                   [](const Diode& d) { return d.getModel() == MODEL_IDEAL; });
+
+    double t_prev = 0.0;
     for (double t = t_step; t <= t_stop; t += t_step) {
-        const int MAX_DIODE_ITERATIONS = 100;
-        const double EPSILON_CURRENT = 1e-9;
-        bool converged = false;
-        int iteration_count = 0;
-
-        do {
-            converged = true;
-            iteration_count++;
-
-            vector<DiodeState> previous_diode_states;
-            for (const auto& diode : circuit.diodes) {
-                previous_diode_states.push_back(diode.getState());
-            }
+        int events_this_step = 0;
+
+        // Advance from t_prev to t, stopping at every diode switching instant on the way.
+        while (t - t_prev > MIN_EVENT_STEP) {
+            double h = t - t_prev;
+
+            if (has_ideal_diodes && events_this_step < MAX_EVENTS_PER_STEP) {
+                vector<DiodeState> start_states;
+                vector<double> start_margins;
+                for (auto& diode : circuit.diodes) {
+                    start_states.push_back(diode.getState());
+                    start_margins.push_back(diodeSwitchingMargin(diode));
+                }
 
-            circuit.assignDiodeBranchIndices();
-            circuit.set_MNA_A(AnalysisType::TRANSIENT);
-            circuit.set_MNA_RHS(AnalysisType::TRANSIENT);
+                double h_event = locateDiodeEvent(circuit, h, start_margins, nonGroundNodes, EPSILON_CURRENT);
+                for (size_t i = 0; i < circuit.diodes.size(); ++i) {
+                    circuit.diodes[i].setState(start_states[i]);
+                }
+                if (h_event < h && h_event > MIN_EVENT_STEP) {
+                    h = h_event;
+                    events_this_step++;
+                    located_events++;
+                }
+            }
 
-            vector<double> solved_solution;
-            try {
-                solved_solution = gaussianElimination(circuit.MNA_A, circuit.MNA_RHS);
-            } catch (const exception& e) {
-                cerr << "Error during Gaussian Elimination at t=" << t << ": " << e.what() << endl;
-                break;
+            if (has_ideal_diodes && diodeSolver == DiodeSolverType::LCP) {
+                vector<DiodeState> start_states;
+                for (const auto& diode : circuit.diodes) {
+                    start_states.push_back(diode.getState());
+                }
+                circuit.setDeltaT(h);
+                if (!assignDiodeStatesLCP(circuit, AnalysisType::TRANSIENT)) {
+                    for (size_t i = 0; i < circuit.diodes.size(); ++i) {
+                        circuit.diodes[i].setState(start_states[i]);
+                    }
+                }
             }
 
-            result_from_vec(circuit, solved_solution, nonGroundNodes);
+            bool converged = false;
+            int iteration_count = 0;
 
-            for (size_t i = 0; i < circuit.diodes.size(); ++i) {
-                Diode& current_diode = circuit.diodes[i];
-                DiodeState old_state = previous_diode_states[i];
-                DiodeState new_state = old_state;
-
-                double v_anode = current_diode.node1->getVoltage();
-                double v_cathode = current_diode.node2->getVoltage();
-                double v_diode_across = v_anode - v_cathode;
-
-                if (current_diode.getDiodeType() == NORMAL) {
-                    if (old_state == STATE_OFF) {
-                        if (v_diode_across >= current_diode.getForwardVoltage() - EPSILON_CURRENT) {
-                            new_state = STATE_FORWARD_ON;
-                        }
-                    } else if (old_state == STATE_FORWARD_ON) {
-                        if (current_diode.getCurrent() < -EPSILON_CURRENT) {
-                            new_state = STATE_OFF;
-                        }
-                    }
-                } else if (current_diode.getDiodeType() == ZENER) {
-                    if (old_state == STATE_OFF) {
-                        if (v_diode_across >= current_diode.getForwardVoltage() - EPSILON_CURRENT) {
-                            new_state = STATE_FORWARD_ON;
-                        } else if (v_diode_across <= -current_diode.getZenerVoltage() + EPSILON_CURRENT) {
-                            new_state = STATE_REVERSE_ON;
-                        }
-                    } else if (old_state == STATE_FORWARD_ON) {
-                        if (current_diode.getCurrent() < -EPSILON_CURRENT) {
-                            new_state = STATE_OFF;
-                        }
-                    } else if (old_state == STATE_REVERSE_ON) {
-                        if (current_diode.getCurrent() > EPSILON_CURRENT) {
-                            new_state = STATE_OFF;
-                        }
-                    }
+            do {
+                converged = true;
+                iteration_count++;
+
+                if (!solveFrozenTransientStep(circuit, h, nonGroundNodes)) {
+                    analysisErrors() << "Error during Gaussian Elimination at t=" << t_prev + h << endl;
+                    break;
                 }
 
-                if (new_state != old_state) {
+                if (updateDiodeStates(circuit, EPSILON_CURRENT)) {
                     converged = false;
-                    current_diode.setState(new_state);
                 }
-            }
-        } while (!converged && iteration_count < MAX_DIODE_ITERATIONS);
+                if (updateDiodeLinearization(circuit)) {
+                    converged = false;
+                }
+            } while (!converged && iteration_count < MAX_DIODE_ITERATIONS);
 
-        if (!converged) {
-            cerr << "Warning: Diode states did not converge at t=" << t << endl;
-        }
+            if (!converged) {
+                analysisErrors() << "Warning: Diode states did not converge at t=" << t_prev + h << endl;
+            }
 
-        for (auto* node : circuit.nodes) {
-            if (!node->isGround) {
-                node->addVoltageHistoryPoint(t, node->getVoltage());
+            // Integration restarts from the accepted point, whether an event or the grid point.
+            double t_accepted = (h < t - t_prev) ? t_prev + h : t;
+            for (auto* node : circuit.nodes) {
+                if (!node->isGround) {
+                    node->addVoltageHistoryPoint(t_accepted, node->getVoltage());
+                }
             }
+            for (auto& vs : circuit.voltageSources) {
+                vs.addCurrentHistoryPoint(t_accepted, vs.getCurrent());
+            }
+
+            circuit.updateComponentStates();
+            t_prev = t_accepted;
         }
-        for (auto& vs : circuit.voltageSources) {
-            vs.addCurrentHistoryPoint(t, vs.getCurrent());
-        }
+        t_prev = t;
+    }
 
-        circuit.updateComponentStates();
+    circuit.setDeltaT(t_step);
+    if (located_events > 0) {
+        analysisOutput() << "// Located " << located_events << " diode switching events." << endl;
     }
-    cout << "// Transient Analysis complete." << endl;
+    reportTearing(tearing);
+    analysisOutput() << "// Transient Analysis complete." << endl;
 }
 
 
 void result_from_vec(Circuit& circuit, const vector<double>& solvedVoltages, const vector<Node*>& nonGroundNodes) {
     if (solvedVoltages.size() < nonGroundNodes.size()) {
-        cerr << "Error: Solution vector size mismatch." << endl;
+        analysisErrors() << "Error: Solution vector size mismatch." << endl;
         return;
     }
     for (size_t i = 0; i < nonGroundNodes.size(); ++i) {
@@ -266,11 +661,12 @@ void result_from_vec(Circuit& circuit, const vector<double>& solvedVoltages, con
 
     for (auto& diode : circuit.diodes) {
         if (diode.getState() == STATE_FORWARD_ON || diode.getState() == STATE_REVERSE_ON) {
-            int diode_solution_idx = diode.getBranchIndex();
-            if (diode_solution_idx != -1 && diode_solution_idx >= 0 && static_cast<size_t>(diode_solution_idx) < solvedVoltages.size()) {
+            // Branch indices count from the first extra variable, after the node voltages
+            int diode_solution_idx = diode.getBranchIndex() + static_cast<int>(nonGroundNodes.size());
+            if (diode.getBranchIndex() != -1 && diode_solution_idx >= 0 && static_cast<size_t>(diode_solution_idx) < solvedVoltages.size()) {
                 diode.setCurrent(solvedVoltages[diode_solution_idx]);
             } else {
-                cerr << "Warning: Diode " << diode.name << " has invalid branch index or solution size mismatch. Cannot set current." << endl;
+                analysisErrors() << "Warning: Diode " << diode.name << " has invalid branch index or solution size mismatch. Cannot set current." << endl;
             }
         }
     }
@@ -283,7 +679,7 @@ void dcSweepAnalysis(Circuit& circuit, const string& sourceName, double start, d
     else if (sourceType == 'I') sweepSource = circuit.findCurrentSource(sourceName);
 
     if (!sweepSource) {
-        cerr << "Error: Sweep source '" << sourceName << "' not found." << endl;
+        analysisErrors() << "Error: Sweep source '" << sourceName << "' not found." << endl;
         return;
     }
 
@@ -291,11 +687,10 @@ void dcSweepAnalysis(Circuit& circuit, const string& sourceName, double start, d
     if (sourceType == 'V') originalValue = static_cast<VoltageSource*>(sweepSource)->value;
     else if (sourceType == 'I') originalValue = static_cast<CurrentSource*>(sweepSource)->value;
 
-    // Perform initial DC analysis to get the base MNA_A matrix
-    dcAnalysis(circuit);
-    
-    // Save a copy of the A matrix for reuse in sweeps
-    vector<vector<double>> a_matrix_copy = circuit.MNA_A;
+    auto setSweepValue = [&](double value) {
+        if (sourceType == 'V') static_cast<VoltageSource*>(sweepSource)->value = value;
+        else if (sourceType == 'I') static_cast<CurrentSource*>(sweepSource)->value = value;
+    };
 
     vector<Node*> nonGroundNodes;
     for (auto* node : circuit.nodes) {
@@ -304,22 +699,7 @@ void dcSweepAnalysis(Circuit& circuit, const string& sourceName, double start, d
         }
     }
 
-    for (double value = start; value <= end; value += step) {
-        if (sourceType == 'V') static_cast<VoltageSource*>(sweepSource)->value = value;
-        else if (sourceType == 'I') static_cast<CurrentSource*>(sweepSource)->value = value;
-        
-        circuit.set_MNA_RHS(AnalysisType::DC); 
-
-        vector<double> solved_solution;
-        try {
-            solved_solution = gaussianElimination(a_matrix_copy, circuit.MNA_RHS);
-        } catch (const exception& e) {
-            cerr << "Error during Gaussian Elimination at sweep value " << value << ": " << e.what() << endl;
-            continue;
-        }
-
-        result_from_vec(circuit, solved_solution, nonGroundNodes);
-
+    auto recordPoint = [&](double value) {
         for (auto* node : circuit.nodes) {
             if (!node->isGround) {
                 node->dc_sweep_history.push_back({value, node->getVoltage()});
@@ -328,21 +708,357 @@ void dcSweepAnalysis(Circuit& circuit, const string& sourceName, double start, d
         for (auto& vs : circuit.voltageSources) {
             vs.dc_sweep_current_history.push_back({value, vs.getCurrent()});
         }
+    };
+
+    // Full operating point at the first sweep value; every later point continues
+    // from the diode states and solution of the one before it.
+    setSweepValue(start);
+    dcAnalysis(circuit);
+    if (circuit.topology.rejected) {
+        setSweepValue(originalValue);
+        analysisOutput() << "// DC Sweep Analysis aborted: invalid circuit topology." << endl;
+        return;
+    }
+    recordPoint(start);
+
+    const double EPSILON_CURRENT = 1e-9;
+    const double MIN_TRANSITION_STEP = 1e-6 * step;
+    const int MAX_TRANSITIONS_PER_STEP = 50;
+    bool nonlinear = any_of(circuit.diodes.begin(), circuit.diodes.end(),
+                            [](const Diode& d) { return d.getModel() == MODEL_SHOCKLEY; });
+    int transitions = 0;
+    int refactorizations = 0;
+
+    // While the diode configuration holds, the circuit is linear and the solution
+    // is affine in the swept value: x(v) = x_base + v * x_unit. One factorization
+    // and two solves per configuration, then every point is a scaled sum.
+    vector<double> x_base, x_unit;
+    auto refactor = [&]() {
+        circuit.assignDiodeBranchIndices();
+        circuit.set_MNA_A(AnalysisType::DC);
+        LUFactorization lu = luFactorize(circuit.MNA_A);
+        setSweepValue(0.0);
+        circuit.set_MNA_RHS(AnalysisType::DC);
+        vector<double> rhs_base = circuit.MNA_RHS;
+        x_base = luSolve(lu, rhs_base);
+        setSweepValue(1.0);
+        circuit.set_MNA_RHS(AnalysisType::DC);
+        for (size_t i = 0; i < rhs_base.size(); ++i) circuit.MNA_RHS[i] -= rhs_base[i];
+        x_unit = luSolve(lu, circuit.MNA_RHS);
+        refactorizations++;
+    };
+
+    // Evaluates value with the diode configuration held and reports whether
+    // every diode is still consistent with its state.
+    vector<double> held;
+    auto solveHeld = [&](double value) {
+        setSweepValue(value);
+        held.resize(x_base.size());
+        for (size_t i = 0; i < held.size(); ++i) held[i] = x_base[i] + value * x_unit[i];
+        result_from_vec(circuit, held, nonGroundNodes);
+        for (auto& diode : circuit.diodes) {
+            if (diodeSwitchingMargin(diode) > EPSILON_CURRENT) return false;
+        }
+        return true;
+    };
+    auto heldMargins = [&](double value) {
+        solveHeld(value);
+        vector<double> margins;
+        for (auto& diode : circuit.diodes) margins.push_back(diodeSwitchingMargin(diode));
+        return margins;
+    };
+
+    if (!nonlinear) refactor();
+
+    double prev = start;
+    for (double target = start + step; target <= end; target += step) {
+        if (nonlinear) {
+            // Newton continuation from the previous point, halving the sub-step on failure.
+            double reached = prev;
+            double sub_step = target - prev;
+            while (reached < target) {
+                double next = min(target, reached + sub_step);
+                vector<DiodeState> saved_states;
+                vector<double> saved_junctions;
+                for (const auto& diode : circuit.diodes) {
+                    saved_states.push_back(diode.getState());
+                    saved_junctions.push_back(diode.junctionVoltage);
+                }
+
+                setSweepValue(next);
+                int iterations = 0;
+                if (solveDCOperatingPoint(circuit, nonGroundNodes, iterations)) {
+                    reached = next;
+                    recordPoint(next);
+                } else if (sub_step > MIN_TRANSITION_STEP) {
+                    for (size_t i = 0; i < circuit.diodes.size(); ++i) {
+                        circuit.diodes[i].setState(saved_states[i]);
+                        circuit.diodes[i].linearize(saved_junctions[i]);
+                    }
+                    sub_step /= 2.0;
+                } else {
+                    analysisErrors() << "Warning: DC sweep did not converge at sweep value " << next << endl;
+                    reached = next;
+                    recordPoint(next);
+                }
+            }
+            prev = target;
+            continue;
+        }
+
+        int transitions_this_step = 0;
+        while (!solveHeld(target)) {
+            if (++transitions_this_step > MAX_TRANSITIONS_PER_STEP) {
+                int iterations = 0;
+                setSweepValue(target);
+                solveDCOperatingPoint(circuit, nonGroundNodes, iterations);
+                refactor();
+                break;
+            }
+
+            // A diode switches somewhere in (prev, target]. With the old configuration
+            // held every margin is affine in the sweep value, so the first crossing
+            // is interpolated exactly instead of bisected.
+            vector<double> hi_margins = heldMargins(target);
+            vector<double> lo_margins = heldMargins(prev);
+            double crossing = target;
+            for (size_t i = 0; i < hi_margins.size(); ++i) {
+                if (hi_margins[i] <= EPSILON_CURRENT) continue;
+                if (lo_margins[i] > EPSILON_CURRENT) {
+                    crossing = prev;
+                    break;
+                }
+                double t = (EPSILON_CURRENT - lo_margins[i]) / (hi_margins[i] - lo_margins[i]);
+                crossing = min(crossing, prev + t * (target - prev));
+            }
+            double lo = crossing;
+            double hi = min(target, crossing + MIN_TRANSITION_STEP);
+            if (lo > prev) {
+                solveHeld(lo);
+                recordPoint(lo);
+            }
+
+            // Re-iterate the diode states just past the transition and refactor once.
+            setSweepValue(hi);
+            int iterations = 0;
+            if (!solveDCOperatingPoint(circuit, nonGroundNodes, iterations)) {
+                analysisErrors() << "Warning: DC sweep did not converge at sweep value " << hi << endl;
+            }
+            refactor();
+            transitions++;
+            prev = hi;
+            if (hi >= target) break;
+            recordPoint(hi);
+        }
+        recordPoint(target);
+        prev = target;
     }
     
     // Restore original value
-    if (sourceType == 'V') static_cast<VoltageSource*>(sweepSource)->value = originalValue;
-    else if (sourceType == 'I') static_cast<CurrentSource*>(sweepSource)->value = originalValue;
-    cout << "// DC Sweep Analysis complete." << endl;
+    setSweepValue(originalValue);
+    if (transitions > 0) {
+        analysisOutput() << "// DC sweep crossed " << transitions << " diode transitions with " << refactorizations << " factorizations." << endl;
+    }
+    analysisOutput() << "// DC Sweep Analysis complete." << endl;
+}
+
+// AC analysis is a small-signal analysis: diodes are linearized at the DC
+// operating point. The bias is cached with the DC fingerprint of the circuit,
+// so only the first AC analysis on a given bias pays for the DC solve. Then
+// checks the AC topology; false if either the bias or the AC circuit is rejected.
+static bool ensureSmallSignalBias(Circuit& circuit) {
+    OperatingPointCache& cache = circuit.operatingPoint;
+    if (circuit.diodes.empty()) {
+        cache = OperatingPointCache();
+        cache.valid = true;
+        return checkTopologyBeforeAssembly(circuit, AnalysisType::AC_SWEEP);
+    }
+
+    uint64_t fingerprint = circuit.dcFingerprint();
+    if (cache.valid && cache.fingerprint == fingerprint && cache.diodeStates.size() == circuit.diodes.size()) {
+        analysisOutput() << "// Reusing cached DC operating point for AC analysis." << endl;
+        return checkTopologyBeforeAssembly(circuit, AnalysisType::AC_SWEEP);
+    }
+
+    dcAnalysis(circuit);
+    if (circuit.topology.rejected) {
+        cache.valid = false;
+        return false;
+    }
+    cache.valid = true;
+    cache.fingerprint = fingerprint;
+    cache.diodeStates.clear();
+    cache.diodeConductances.clear();
+    for (auto& diode : circuit.diodes) {
+        double g = 0.0;
+        if (diode.getModel() == MODEL_SHOCKLEY) {
+            diode.evaluateCurrent(diode.node1->getVoltage() - diode.node2->getVoltage(), &g);
+        }
+        cache.diodeStates.push_back(diode.getState());
+        cache.diodeConductances.push_back(g);
+    }
+    return checkTopologyBeforeAssembly(circuit, AnalysisType::AC_SWEEP);
+}
+
+// Thiele continued-fraction interpolant through (x[i], y[i]) evaluated at xq.
+// Circuit responses are rational in omega, so a few points already pin down a
+// resonance that a piecewise-linear plot would flatten. A vanishing inverse
+// difference means the lower-order fraction fits already; it is cut there.
+static complex<double> thieleInterpolate(const vector<double>& x, const vector<complex<double>>& y, double xq) {
+    size_t n = x.size();
+    vector<complex<double>> phi(y);
+    vector<complex<double>> a{phi[0]};
+    for (size_t k = 1; k < n; ++k) {
+        bool degenerate = false;
+        for (size_t i = k; i < n; ++i) {
+            complex<double> d = phi[i] - phi[k - 1];
+            if (abs(d) <= 1e-12 * max(abs(phi[i]), abs(phi[k - 1]))) {
+                degenerate = true;
+                break;
+            }
+            phi[i] = (x[i] - x[k - 1]) / d;
+        }
+        if (degenerate) break;
+        a.push_back(phi[k]);
+    }
+
+    complex<double> r = a.back();
+    for (int k = (int)a.size() - 2; k >= 0; --k) {
+        if (r == complex<double>(0.0, 0.0)) return complex<double>(NAN, NAN);
+        r = a[k] + (xq - x[k]) / r;
+    }
+    return r;
+}
+
+// Error of the plotted (log-linear) curve at the geometric midpoint of
+// interval i, judged against a rational interpolant through the four nearest
+// points. Combines a relative complex error and a dB error on every column;
+// values above 1 exceed the tolerance.
+static double acIntervalError(const vector<double>& freqs, const vector<vector<complex<double>>>& solutions,
+                              const vector<double>& scales, size_t i) {
+    const double RELTOL = 1e-3;     // Relative to the column's largest value
+    const double DB_TOL = 0.1;      // Magnitude error in dB
+    const double DB_FLOOR = 1e-6;   // dB error ignored this far below the column peak
+
+    if (solutions[i].empty() || solutions[i + 1].empty()) return 0.0;
+
+    size_t count = freqs.size();
+    size_t first = (i == 0) ? 0 : i - 1;
+    if (first + 4 > count) first = (count >= 4) ? count - 4 : 0;
+    vector<size_t> support;
+    for (size_t p = first; p < count && support.size() < 4; ++p) {
+        if (!solutions[p].empty()) support.push_back(p);
+    }
+
+    double omega_mid = 2.0 * M_PI * sqrt(freqs[i] * freqs[i + 1]);
+    double worst = 0.0;
+    for (size_t j = 0; j < scales.size(); ++j) {
+        if (scales[j] <= 0.0) continue;
+        vector<double> x;
+        vector<complex<double>> y;
+        for (size_t p : support) {
+            x.push_back(2.0 * M_PI * freqs[p]);
+            y.push_back(solutions[p][j]);
+        }
+        complex<double> rational = thieleInterpolate(x, y, omega_mid);
+        complex<double> linear = 0.5 * (solutions[i][j] + solutions[i + 1][j]);
+        if (!isfinite(rational.real()) || !isfinite(rational.imag())) {
+            return numeric_limits<double>::infinity(); // Pole inside the interval
+        }
+
+        worst = max(worst, abs(rational - linear) / scales[j] / RELTOL);
+        double floor = DB_FLOOR * scales[j];
+        if (abs(rational) > floor || abs(linear) > floor) {
+            double db_error = 20.0 * fabs(log10(max(abs(rational), floor) / max(abs(linear), floor)));
+            worst = max(worst, db_error / DB_TOL);
+        }
+    }
+    return worst;
+}
+
+// Adaptive placement: a coarse logarithmic grid, then repeated passes that add
+// the geometric midpoint of every interval whose error estimate exceeds the
+// tolerance, worst first, until nothing exceeds it or the point budget is spent.
+static void adaptiveACFrequencies(double start_freq, double stop_freq, int budget, size_t num_unknowns,
+                                  const function<void(const vector<double>&, vector<vector<complex<double>>>&)>& solve,
+                                  vector<double>& freqs, vector<vector<complex<double>>>& solutions) {
+    const double MIN_RATIO = 1.0 + 1e-9; // Intervals narrower than this are never split
+    const size_t BUDGET_SLICES = 8;      // A pass adds at most 1/8 of the remaining budget
+    const size_t MIN_BATCH = 4;
+    const int COARSE_PER_DECADE = 5;
+
+    int decades = (int)ceil(log10(stop_freq / start_freq));
+    int coarse = min(budget, max(5, COARSE_PER_DECADE * decades + 1));
+    freqs.clear();
+    for (int i = 0; i < coarse; ++i) {
+        freqs.push_back(start_freq * pow(stop_freq / start_freq, (double)i / (double)(coarse - 1)));
+    }
+    solve(freqs, solutions);
+
+    int passes = 0;
+    while ((int)freqs.size() < budget) {
+        vector<double> scales(num_unknowns, 0.0);
+        for (const auto& sol : solutions) {
+            for (size_t j = 0; j < sol.size() && j < num_unknowns; ++j) {
+                scales[j] = max(scales[j], abs(sol[j]));
+            }
+        }
+
+        vector<pair<double, size_t>> flagged;
+        for (size_t i = 0; i + 1 < freqs.size(); ++i) {
+            if (freqs[i + 1] < freqs[i] * MIN_RATIO) continue;
+            double err = acIntervalError(freqs, solutions, scales, i);
+            if (err > 1.0) flagged.push_back({err, i});
+        }
+        if (flagged.empty()) break;
+
+        sort(flagged.begin(), flagged.end(), [](const pair<double, size_t>& a, const pair<double, size_t>& b) {
+            return a.first > b.first;
+        });
+        // Each pass spends only a slice of what is left, so the budget follows
+        // the worst intervals as they move rather than being spread evenly
+        size_t batch = max<size_t>(MIN_BATCH, (budget - freqs.size()) / BUDGET_SLICES);
+        flagged.resize(min({flagged.size(), batch, (size_t)(budget - (int)freqs.size())}));
+
+        vector<double> midpoints;
+        for (const auto& f : flagged) {
+            midpoints.push_back(sqrt(freqs[f.second] * freqs[f.second + 1]));
+        }
+        vector<vector<complex<double>>> mid_solutions;
+        solve(midpoints, mid_solutions);
+
+        // Merge the new points in frequency order
+        vector<size_t> order(midpoints.size());
+        for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) { return midpoints[a] < midpoints[b]; });
+        vector<double> merged_freqs;
+        vector<vector<complex<double>>> merged_solutions;
+        size_t k = 0;
+        for (size_t i = 0; i < freqs.size(); ++i) {
+            while (k < order.size() && midpoints[order[k]] < freqs[i]) {
+                merged_freqs.push_back(midpoints[order[k]]);
+                merged_solutions.push_back(move(mid_solutions[order[k]]));
+                ++k;
+            }
+            merged_freqs.push_back(freqs[i]);
+            merged_solutions.push_back(move(solutions[i]));
+        }
+        freqs.swap(merged_freqs);
+        solutions.swap(merged_solutions);
+        ++passes;
+    }
+
+    analysisOutput() << "// Adaptive AC sweep placed " << freqs.size() << " points (" << coarse << " coarse, "
+                     << passes << " refinement passes)." << endl;
 }
 
-void acSweepAnalysis(Circuit& circuit, const std::string& sourceName, double start_freq, double stop_freq, int num_points, const std::string& sweep_type) {
-    cout << "// Performing AC Sweep Analysis..." << endl;
+void acSweepAnalysis(Circuit& circuit, const std::string& sourceName, double start_freq, double stop_freq, int num_points, const std::string& sweep_type, ACSolverType acSolver) {
+    analysisOutput() << "// Performing AC Sweep Analysis..." << endl;
     circuit.clearComponentHistory();
 
     ACVoltageSource* acSource = circuit.findACVoltageSource(sourceName);
     if (!acSource) {
-        cerr << "Error: AC source '" << sourceName << "' not found for sweep." << endl;
+        analysisErrors() << "Error: AC source '" << sourceName << "' not found for sweep." << endl;
         return;
     }
 
@@ -355,48 +1071,241 @@ void acSweepAnalysis(Circuit& circuit, const std::string& sourceName, double sta
     
     if (num_points < 2) num_points = 2;
 
-    for (int i = 0; i < num_points; ++i) {
-        double current_freq;
-        if (sweep_type == "Logarithmic") {
-            current_freq = start_freq * pow(stop_freq / start_freq, (double)i / (double)(num_points - 1));
-        } else { // Default to Linear
-             current_freq = start_freq + i * (stop_freq - start_freq) / (double)(num_points - 1);
+    if (!ensureSmallSignalBias(circuit)) {
+        analysisOutput() << "// AC Sweep Analysis aborted: invalid circuit topology." << endl;
+        return;
+    }
+
+    bool adaptive = (sweep_type == "Adaptive");
+    if (adaptive && (start_freq <= 1e-9 || stop_freq <= start_freq)) {
+        analysisErrors() << "Error: Adaptive AC sweep needs 0 < start frequency < stop frequency." << endl;
+        return;
+    }
+
+    vector<double> frequencies;
+    if (!adaptive) {
+        for (int i = 0; i < num_points; ++i) {
+            double current_freq;
+            if (sweep_type == "Logarithmic") {
+                current_freq = start_freq * pow(stop_freq / start_freq, (double)i / (double)(num_points - 1));
+            } else { // Default to Linear
+                 current_freq = start_freq + i * (stop_freq - start_freq) / (double)(num_points - 1);
+            }
+           
+            if (current_freq <= 1e-9) continue; 
+            frequencies.push_back(current_freq);
         }
-       
-        if (current_freq <= 1e-9) continue; 
+    }
 
-        circuit.set_MNA_A(AnalysisType::AC_SWEEP, current_freq);
-        circuit.set_MNA_RHS(AnalysisType::AC_SWEEP, current_freq);
+    // G, C and Gamma are assembled once; each point only forms G + jwC + Gamma/(jw)
+    // over the fixed nonzero pattern. Pivot order and fill are analysed once as
+    // well, at the middle of the sweep, and kept for later sweeps over the same
+    // pattern (e.g. the next point of a parameter sweep).
+    ACSystemParts parts;
+    circuit.buildACSystemParts(parts);
+    vector<complex<double>> rhs;
+    circuit.assembleACRHS(rhs);
+    const int system_size = parts.G.size();
+
+    double pattern_freq = adaptive ? sqrt(start_freq * stop_freq)
+                                   : (frequencies.empty() ? 0.0 : frequencies[frequencies.size() / 2]);
+
+    // With series reduction on, every point folds the series chains first and
+    // the sparse LU runs on the reduced system, analysed once per sweep
+    SeriesReduction series;
+    SparseLUPattern seriesPattern;
+    bool useSeries = seriesReductionEnabled() && pattern_freq > 0.0 &&
+                     series.build(parts.nonzeros, system_size, nonGroundNodes.size());
+    if (useSeries) {
+        vector<vector<complex<double>>> sample(system_size, vector<complex<double>>(system_size, {0.0, 0.0}));
+        parts.form(2.0 * M_PI * pattern_freq, sample);
+        vector<complex<double>> b = rhs, b_reduced;
+        vector<vector<complex<double>>> reduced;
+        useSeries = series.reduce(sample, b, reduced, b_reduced);
+        if (useSeries) {
+            vector<complex<double>> entries;
+            for (const auto& [r, c] : series.nonzeros) entries.push_back(reduced[r][c]);
+            seriesPattern = analyzeSparseLU(series.reduced, series.nonzeros, entries);
+            analysisOutput() << "// Series reduction: " << system_size << " -> " << series.reduced << " unknowns." << endl;
+        }
+    }
 
-        vector<complex<double>> solution;
-        try {
-            solution = gaussianElimination(circuit.MNA_A_Complex, circuit.MNA_RHS_Complex);
-        } catch (const exception& e) {
-            cerr << "Error during AC analysis at frequency " << current_freq << " Hz: " << e.what() << endl;
-            continue; // Skip to the next frequency point
+    if (!useSeries && pattern_freq > 0.0 && (circuit.acPattern.nonzeros != parts.nonzeros || circuit.acPattern.pattern.n != system_size)) {
+        vector<complex<double>> sample;
+        parts.formEntries(2.0 * M_PI * pattern_freq, sample);
+        circuit.acPattern.pattern = analyzeSparseLU(system_size, parts.nonzeros, sample);
+        circuit.acPattern.nonzeros = parts.nonzeros;
+    }
+    const SparseLUPattern& pattern = circuit.acPattern.pattern;
+
+    // Frequency points are independent: each worker solves in its own workspace
+    // and writes only its own slots. A failed point is left empty. Without the
+    // series reduction a workspace is one value per nonzero of the factors.
+    atomic<bool> pivotFailed(false);
+    function<void(const vector<double>&, vector<vector<complex<double>>>&)> solveFrequencies = [&](const vector<double>& freqs, vector<vector<complex<double>>>& solutions) {
+        solutions.assign(freqs.size(), {});
+        ThreadPool::shared().parallelFor(freqs.size(), [&](size_t begin, size_t end) {
+            vector<vector<complex<double>>> A;
+            if (useSeries) A.assign(system_size, vector<complex<double>>(system_size, {0.0, 0.0}));
+            vector<vector<complex<double>>> reduced;
+            vector<complex<double>> entries, lu;
+            for (size_t i = begin; i < end; ++i) {
+                double omega = 2.0 * M_PI * freqs[i];
+
+                vector<complex<double>> solution;
+                bool solved;
+                if (useSeries) {
+                    parts.form(omega, A);
+                    vector<complex<double>> b = rhs, b_reduced, y;
+                    solved = series.reduce(A, b, reduced, b_reduced);
+                    if (solved) {
+                        seriesPattern.load(reduced, lu);
+                        solved = sparseLUSolve(seriesPattern, lu, b_reduced, y);
+                    }
+                    if (solved) solution = series.expand(A, b, y);
+                    // Chain ends picked up entries outside the pattern that form() does not reset
+                    for (const auto& adjacent : series.neighbours) {
+                        for (int j : adjacent) {
+                            for (int k : adjacent) A[j][k] = 0.0;
+                        }
+                    }
+                } else {
+                    parts.formEntries(omega, entries);
+                    pattern.load(entries, lu);
+                    solved = sparseLUSolve(pattern, lu, rhs, solution);
+                    // The fixed pivot order is unstable at this frequency
+                    if (!solved) pivotFailed = true;
+                }
+                if (!solved) {
+                    vector<vector<complex<double>>> dense(system_size, vector<complex<double>>(system_size, {0.0, 0.0}));
+                    parts.form(omega, dense);
+                    try {
+                        solution = gaussianElimination(dense, rhs);
+                    } catch (const exception&) {
+                        continue; // Reported below, in frequency order
+                    }
+                }
+                solutions[i] = move(solution);
+            }
+        });
+    };
+
+    // Reduced-order path: every point is evaluated from the projected model and
+    // checked by its full-system residual; points that fail it are solved directly.
+    vector<string> unknownNames = circuit.acUnknownNames();
+
+    const double ROM_TOLERANCE = 1e-6;
+    size_t rom_fallbacks = 0;
+    bool useReducedModel = true;
+    if (acSolver == ACSolverType::REDUCED_ORDER && system_size > 0) {
+        double fmin = adaptive ? start_freq : (frequencies.empty() ? 0.0 : *min_element(frequencies.begin(), frequencies.end()));
+        double fmax = adaptive ? stop_freq : (frequencies.empty() ? 0.0 : *max_element(frequencies.begin(), frequencies.end()));
+        ReducedACModel& model = circuit.acReducedModel;
+        uint64_t fingerprint = acSystemFingerprint(parts, rhs);
+
+        if (fmin > 0.0 && model.fingerprint == fingerprint && model.unknownNames == unknownNames && model.covers(fmin, fmax)) {
+            analysisOutput() << "// Reusing reduced AC model of order " << model.order() << "." << endl;
+        } else if (fmin > 0.0 && buildReducedACModel(parts, rhs, fmin, fmax, model, ROM_TOLERANCE)) {
+            model.unknownNames = unknownNames;
+            analysisOutput() << "// Reduced AC model: order " << model.order() << " of " << system_size << " from "
+                             << model.expansionFrequencies.size() << " expansion points, max residual " << model.errorEstimate << "." << endl;
+        } else {
+            analysisErrors() << "Warning: Reduced AC model could not be built; solving every point directly." << endl;
+            model = ReducedACModel();
         }
 
-        // 3. Store the results (magnitude of voltage/current)
-        for (size_t j = 0; j < nonGroundNodes.size(); ++j) {
-            if (j < solution.size()) {
-                double magnitude = abs(solution[j]);
-                nonGroundNodes[j]->ac_sweep_history.push_back({current_freq, magnitude});
+        // A reduced solve is dense: about q^3/3 for the q x q LU plus n*q to lift
+        // and nnz for the residual check. Keep it only when that undercuts the
+        // sparse factorization it replaces.
+        if (!model.empty()) {
+            double q = model.order();
+            double reduced_cost = q * q * q / 3.0 + system_size * q + parts.nonzeros.size();
+            const SparseLUPattern& direct = useSeries ? seriesPattern : pattern;
+            double direct_cost = direct.columns.size() + direct.flops;
+            if (reduced_cost >= direct_cost) {
+                analysisOutput() << "// Reduced model of order " << model.order() << " is no cheaper than the sparse solve; solving directly." << endl;
+                useReducedModel = false;
             }
         }
-        // You would also store current magnitudes for components here
+
+        if (!model.empty() && useReducedModel) {
+            auto solveDirect = solveFrequencies;
+            solveFrequencies = [&, solveDirect](const vector<double>& freqs, vector<vector<complex<double>>>& solutions) {
+                solutions.assign(freqs.size(), {});
+                vector<char> rejected(freqs.size(), 0);
+                ThreadPool::shared().parallelFor(freqs.size(), [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        vector<complex<double>> x;
+                        if (model.evaluate(freqs[i], x) && acRelativeResidual(parts, rhs, freqs[i], x) <= ROM_TOLERANCE) {
+                            solutions[i] = move(x);
+                        } else {
+                            rejected[i] = 1;
+                        }
+                    }
+                });
+
+                vector<double> direct_freqs;
+                vector<size_t> direct_index;
+                for (size_t i = 0; i < freqs.size(); ++i) {
+                    if (rejected[i]) {
+                        direct_freqs.push_back(freqs[i]);
+                        direct_index.push_back(i);
+                    }
+                }
+                if (direct_freqs.empty()) return;
+                vector<vector<complex<double>>> direct;
+                solveDirect(direct_freqs, direct);
+                for (size_t k = 0; k < direct_index.size(); ++k) {
+                    solutions[direct_index[k]] = move(direct[k]);
+                }
+                rom_fallbacks += direct_index.size();
+            };
+        }
+    }
+
+    vector<vector<complex<double>>> solutions;
+    if (adaptive) {
+        adaptiveACFrequencies(start_freq, stop_freq, num_points, nonGroundNodes.size(), solveFrequencies, frequencies, solutions);
+    } else {
+        solveFrequencies(frequencies, solutions);
+    }
+
+    if (pivotFailed) circuit.acPattern = ACPatternCache(); // Re-analyse next time
+
+    if (rom_fallbacks > 0) {
+        analysisOutput() << "// " << rom_fallbacks << " point(s) exceeded the reduced model's residual tolerance and were solved directly." << endl;
+    }
+
+    // Every unknown keeps its complex value at every frequency: node voltages,
+    // then AC source branch currents, one contiguous column each.
+    ACSweepResult& result = circuit.acResult;
+    result.reset(unknownNames, frequencies);
+
+    for (size_t i = 0; i < frequencies.size(); ++i) {
+        if (solutions[i].empty()) {
+            analysisErrors() << "Error during AC analysis at frequency " << frequencies[i] << " Hz." << endl;
+            continue; // Skip to the next frequency point
+        }
+        for (size_t k = 0; k < unknownNames.size() && k < solutions[i].size(); ++k) {
+            result.column(k)[i] = solutions[i][k];
+        }
+        // Magnitude history for the nodes
+        for (size_t j = 0; j < nonGroundNodes.size(); ++j) {
+            nonGroundNodes[j]->ac_sweep_history.push_back({frequencies[i], abs(solutions[i][j])});
+        }
     }
 
-    cout << "// AC Sweep Analysis complete." << endl;
+    analysisOutput() << "// AC Sweep Analysis complete." << endl;
 }
 
 // --- NEW (Skeleton) ---
 // Implementation for Phase Sweep would be similar
 void phaseSweepAnalysis(Circuit& circuit, const std::string& sourceName, double base_freq, double start_phase, double stop_phase, int num_points) {
-    cout << "// Performing Phase Sweep Analysis..." << endl;
+    analysisOutput() << "// Performing Phase Sweep Analysis..." << endl;
     circuit.clearComponentHistory();
     ACVoltageSource* acSource = circuit.findACVoltageSource(sourceName);
     if (!acSource) {
-        cerr << "Error: AC source '" << sourceName << "' not found for sweep." << endl;
+        analysisErrors() << "Error: AC source '" << sourceName << "' not found for sweep." << endl;
         return;
     }
     
@@ -409,36 +1318,241 @@ void phaseSweepAnalysis(Circuit& circuit, const std::string& sourceName, double
 
     if (num_points < 2) num_points = 2;
     if (base_freq <= 1e-9) {
-        cerr << "Error: Base frequency for phase sweep must be positive." << endl;
+        analysisErrors() << "Error: Base frequency for phase sweep must be positive." << endl;
         return;
     }
 
-    circuit.set_MNA_A(AnalysisType::AC_SWEEP, base_freq);
+    if (!ensureSmallSignalBias(circuit)) {
+        analysisOutput() << "// Phase Sweep Analysis aborted: invalid circuit topology." << endl;
+        return;
+    }
+    ACSystemParts parts;
+    circuit.buildACSystemParts(parts);
+    int size = parts.G.size();
+    double omega = 2.0 * M_PI * base_freq;
 
+    // The AC system is linear in the swept phasor, so by superposition
+    // x(phase) = x_rest + e^(j*phase) * x_unit: one factorization, two solves.
     double originalPhase = acSource->phase;
+    double originalMagnitude = acSource->magnitude;
 
-    for (int i = 0; i < num_points; ++i) {
-        double current_phase = start_phase + i * (stop_phase - start_phase) / (double)(num_points - 1);
-        acSource->phase = current_phase;
-
+    vector<complex<double>> x_rest, x_unit;
+    try {
+        acSource->magnitude = 0.0;
         circuit.set_MNA_RHS(AnalysisType::AC_SWEEP, base_freq);
+        vector<complex<double>> rhs_rest = circuit.MNA_RHS_Complex;
 
-        vector<complex<double>> solution;
-        try {
-            solution = gaussianElimination(circuit.MNA_A_Complex, circuit.MNA_RHS_Complex);
-        } catch (const exception& e) {
-            cerr << "Error during Phase analysis at phase " << current_phase << " deg: " << e.what() << endl;
-            continue;
+        acSource->magnitude = originalMagnitude;
+        acSource->phase = 0.0;
+        circuit.set_MNA_RHS(AnalysisType::AC_SWEEP, base_freq);
+        vector<complex<double>> rhs_unit = circuit.MNA_RHS_Complex;
+        for (size_t i = 0; i < rhs_unit.size(); ++i) rhs_unit[i] -= rhs_rest[i];
+
+        vector<complex<double>> entries, lu;
+        parts.formEntries(omega, entries);
+        if (circuit.acPattern.nonzeros != parts.nonzeros || circuit.acPattern.pattern.n != size) {
+            circuit.acPattern.pattern = analyzeSparseLU(size, parts.nonzeros, entries);
+            circuit.acPattern.nonzeros = parts.nonzeros;
+        }
+        const SparseLUPattern& pattern = circuit.acPattern.pattern;
+        pattern.load(entries, lu);
+        if (sparseLUFactor(pattern, lu)) {
+            sparseLUSolveFactored(pattern, lu, rhs_rest, x_rest);
+            sparseLUSolveFactored(pattern, lu, rhs_unit, x_unit);
+        } else {
+            circuit.acPattern = ACPatternCache(); // Re-analyse next time
+            // Unstable pivot order: dense solves
+            vector<vector<complex<double>>> dense(size, vector<complex<double>>(size, {0.0, 0.0}));
+            parts.form(omega, dense);
+            x_rest = gaussianElimination(dense, rhs_rest);
+            x_unit = gaussianElimination(dense, rhs_unit);
         }
+    } catch (const exception& e) {
+        analysisErrors() << "Error during Phase analysis: " << e.what() << endl;
+        acSource->magnitude = originalMagnitude;
+        acSource->phase = originalPhase;
+        return;
+    }
+
+    for (int i = 0; i < num_points; ++i) {
+        double current_phase = start_phase + i * (stop_phase - start_phase) / (double)(num_points - 1);
+        complex<double> rotation = polar(1.0, current_phase * M_PI / 180.0);
 
         for (size_t j = 0; j < nonGroundNodes.size(); ++j) {
-             if (j < solution.size()) {
-                double magnitude = abs(solution[j]);
+             if (j < x_rest.size()) {
+                double magnitude = abs(x_rest[j] + rotation * x_unit[j]);
                 nonGroundNodes[j]->phase_sweep_history.push_back({current_phase, magnitude});
              }
         }
     }
     
     acSource->phase = originalPhase; 
-    cout << "// Phase Sweep Analysis complete." << endl;
-}
\ No newline at end of file
+    analysisOutput() << "// Phase Sweep Analysis complete." << endl;
+}
+// Adjoint sensitivities. For an output y = e_o' x of A x = b, one transposed
+// solve A' lambda = e_o gives dy/dp = lambda' (db/dp - dA/dp x) for every
+// parameter p at once. In DC, x is the operating point itself. Its factors
+// stay inside the reductions and solver paths of solveMNA, which keep none,
+// so A' is factored once more, through the same gaussianElimination dispatch.
+bool dcSensitivityAnalysis(Circuit& circuit, const string& output, vector<pair<string, double>>& sensitivities) {
+    analysisOutput() << "// Performing DC Sensitivity Analysis..." << endl;
+    sensitivities.clear();
+
+    dcAnalysis(circuit, DiodeSolverType::RELAXATION, true);
+    if (circuit.topology.rejected) return false;
+
+    // At a converged Newton point the companion matrix is the Jacobian, so the
+    // same formula holds for exponential diodes.
+    for (auto& diode : circuit.diodes) {
+        if (diode.getModel() == MODEL_SHOCKLEY) {
+            diode.linearize(diode.node1->getVoltage() - diode.node2->getVoltage());
+        }
+    }
+
+    int n = circuit.countNonGroundNodes();
+    int output_index = -1;
+    Node* outputNode = circuit.findNode(output);
+    if (outputNode && !outputNode->isGround) {
+        output_index = circuit.getNodeMatrixIndex(outputNode);
+    }
+    for (size_t i = 0; output_index == -1 && i < circuit.voltageSources.size(); ++i) {
+        if (circuit.voltageSources[i].name == output) output_index = n + i;
+    }
+    for (size_t i = 0; output_index == -1 && i < circuit.inductors.size(); ++i) {
+        if (circuit.inductors[i].name == output) output_index = n + circuit.voltageSources.size() + i;
+    }
+    if (output_index == -1) {
+        analysisErrors() << "Error: Sensitivity output '" << output << "' is not a node, voltage source or inductor." << endl;
+        return false;
+    }
+
+    circuit.assignDiodeBranchIndices();
+    circuit.set_MNA_A(AnalysisType::DC);
+    const vector<double>& x = circuit.MNA_solution;
+    const size_t size = circuit.MNA_A.size();
+    if (x.size() != size) {
+        analysisErrors() << "Error: DC Sensitivity needs a solved operating point." << endl;
+        return false;
+    }
+    vector<vector<double>> transposed(size, vector<double>(size));
+    for (size_t r = 0; r < size; ++r) {
+        for (size_t c = 0; c < size; ++c) transposed[c][r] = circuit.MNA_A[r][c];
+    }
+    vector<double> e_o(size, 0.0);
+    e_o[output_index] = 1.0;
+    vector<double> lambda = gaussianElimination(transposed, e_o);
+
+    auto value = [&](const vector<double>& v, const Node* node) {
+        int idx = circuit.getNodeMatrixIndex(node);
+        return idx == -1 ? 0.0 : v[idx];
+    };
+    // lambda' S x for a two-terminal conductance stamp S
+    auto stampProduct = [&](const Node* n1, const Node* n2) {
+        return (value(lambda, n1) - value(lambda, n2)) * (value(x, n1) - value(x, n2));
+    };
+
+    for (const auto& res : circuit.resistors) {
+        sensitivities.push_back({res.name, stampProduct(res.node1, res.node2) / (res.resistance * res.resistance)});
+    }
+    for (const auto& cap : circuit.capacitors) {
+        sensitivities.push_back({cap.name, -stampProduct(cap.node1, cap.node2) / circuit.delta_t});
+    }
+    for (size_t i = 0; i < circuit.inductors.size(); ++i) {
+        int k = n + circuit.voltageSources.size() + i;
+        sensitivities.push_back({circuit.inductors[i].name, lambda[k] * (x[k] - circuit.inductors[i].prevCurrent) / circuit.delta_t});
+    }
+    for (size_t i = 0; i < circuit.voltageSources.size(); ++i) {
+        sensitivities.push_back({circuit.voltageSources[i].name, lambda[n + i]});
+    }
+    for (const auto& cs : circuit.currentSources) {
+        sensitivities.push_back({cs.name, value(lambda, cs.node1) - value(lambda, cs.node2)});
+    }
+
+    analysisOutput() << "// DC Sensitivity Analysis complete." << endl;
+    return true;
+}
+
+bool acSensitivityAnalysis(Circuit& circuit, const string& output, double frequency, vector<pair<string, complex<double>>>& sensitivities) {
+    analysisOutput() << "// Performing AC Sensitivity Analysis..." << endl;
+    sensitivities.clear();
+    if (frequency <= 0.0) {
+        analysisErrors() << "Error: AC sensitivity needs a positive frequency." << endl;
+        return false;
+    }
+
+    if (!ensureSmallSignalBias(circuit)) return false;
+
+    vector<string> unknownNames = circuit.acUnknownNames();
+    int output_index = -1;
+    for (size_t i = 0; i < unknownNames.size(); ++i) {
+        if (unknownNames[i] == output) output_index = i;
+    }
+    if (output_index == -1) {
+        analysisErrors() << "Error: Sensitivity output '" << output << "' is not an AC unknown." << endl;
+        return false;
+    }
+
+    ACSystemParts parts;
+    circuit.buildACSystemParts(parts);
+    vector<complex<double>> rhs;
+    circuit.assembleACRHS(rhs);
+    int size = parts.G.size();
+    double omega = 2.0 * M_PI * frequency;
+
+    vector<complex<double>> entries, lu;
+    parts.formEntries(omega, entries);
+    vector<complex<double>> e_o(size, {0.0, 0.0});
+    e_o[output_index] = 1.0;
+
+    // Same pivot order as the AC sweep over this nonzero set; analysed only on a mismatch
+    if (circuit.acPattern.nonzeros != parts.nonzeros || circuit.acPattern.pattern.n != size) {
+        circuit.acPattern.pattern = analyzeSparseLU(size, parts.nonzeros, entries);
+        circuit.acPattern.nonzeros = parts.nonzeros;
+    }
+    const SparseLUPattern& pattern = circuit.acPattern.pattern;
+
+    vector<complex<double>> x, lambda;
+    pattern.load(entries, lu);
+    if (sparseLUSolve(pattern, lu, rhs, x)) {
+        sparseLUSolveTransposed(pattern, lu, e_o, lambda);
+    } else {
+        circuit.acPattern = ACPatternCache(); // Re-analyse next time
+        // Unstable pivot order: dense solves of A and A'
+        vector<vector<complex<double>>> dense(size, vector<complex<double>>(size, {0.0, 0.0}));
+        parts.form(omega, dense);
+        vector<vector<complex<double>>> transposed(size, vector<complex<double>>(size));
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) transposed[c][r] = dense[r][c];
+        }
+        x = gaussianElimination(dense, rhs);
+        lambda = gaussianElimination(transposed, e_o);
+    }
+
+    auto value = [&](const vector<complex<double>>& v, const Node* node) {
+        int idx = circuit.getNodeMatrixIndex(node);
+        return idx == -1 ? complex<double>(0.0, 0.0) : v[idx];
+    };
+    auto stampProduct = [&](const Node* n1, const Node* n2) {
+        return (value(lambda, n1) - value(lambda, n2)) * (value(x, n1) - value(x, n2));
+    };
+    complex<double> jw(0.0, omega);
+
+    for (const auto& res : circuit.resistors) {
+        sensitivities.push_back({res.name, stampProduct(res.node1, res.node2) / (res.resistance * res.resistance)});
+    }
+    for (const auto& cap : circuit.capacitors) {
+        sensitivities.push_back({cap.name, -jw * stampProduct(cap.node1, cap.node2)});
+    }
+    for (const auto& ind : circuit.inductors) {
+        sensitivities.push_back({ind.name, stampProduct(ind.node1, ind.node2) / (jw * ind.inductance * ind.inductance)});
+    }
+    // AC source magnitudes: b holds magnitude * e^(j phase)
+    int n = circuit.countNonGroundNodes();
+    for (size_t i = 0; i < circuit.acVoltageSources.size(); ++i) {
+        const auto& src = circuit.acVoltageSources[i];
+        sensitivities.push_back({src.name, lambda[n + i] * polar(1.0, src.phase * M_PI / 180.0)});
+    }
+
+    analysisOutput() << "// AC Sensitivity Analysis complete." << endl;
+    return true;
+}
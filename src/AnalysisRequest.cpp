@@ -0,0 +1,128 @@
+#include "Analysis.h"
+#include <iostream>
+#include <streambuf>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Discards everything
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+thread_local bool threadQuiet = false;
+
+ostream& nullStream() {
+    thread_local NullBuffer buffer;
+    thread_local ostream stream(&buffer);
+    return stream;
+}
+
+// Linear interpolation of a (x, y) history at x; clamps outside its range
+double sampleHistory(const vector<pair<double, double>>& history, double x) {
+    if (history.empty()) return numeric_limits<double>::quiet_NaN();
+    if (x <= history.front().first) return history.front().second;
+    if (x >= history.back().first) return history.back().second;
+    auto it = lower_bound(history.begin(), history.end(), x,
+                          [](const pair<double, double>& p, double value) { return p.first < value; });
+    const auto& hi = *it;
+    const auto& lo = *(it - 1);
+    if (hi.first == lo.first) return hi.second;
+    return lo.second + (hi.second - lo.second) * (x - lo.first) / (hi.first - lo.first);
+}
+
+} // namespace
+
+ostream& analysisOutput() {
+    return threadQuiet ? nullStream() : cout;
+}
+
+ostream& analysisErrors() {
+    return threadQuiet ? nullStream() : cerr;
+}
+
+bool setThreadQuiet(bool quiet) {
+    bool previous = threadQuiet;
+    threadQuiet = quiet;
+    return previous;
+}
+
+bool AnalysisRequest::validate(Circuit& circuit, const vector<string>& outputs) const {
+    if (outputs.empty()) {
+        analysisErrors() << "Error: At least one output node is needed." << endl;
+        return false;
+    }
+    for (const auto& name : outputs) {
+        if (!circuit.findNode(name)) {
+            analysisErrors() << "Error: Output node '" << name << "' not found." << endl;
+            return false;
+        }
+    }
+    if (analysis == AnalysisType::TRANSIENT && (t_step <= 0.0 || t_stop < t_step)) {
+        analysisErrors() << "Error: Transient needs 0 < step <= stop time." << endl;
+        return false;
+    }
+    if (analysis == AnalysisType::AC_SWEEP) {
+        if (!circuit.findACVoltageSource(acSource)) {
+            analysisErrors() << "Error: AC source '" << acSource << "' not found." << endl;
+            return false;
+        }
+        if (ac_points < 1 || f_start <= 0.0 || f_stop < f_start) {
+            analysisErrors() << "Error: AC sweep needs at least one point and 0 < start <= stop frequency." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<double> AnalysisRequest::axis() const {
+    vector<double> points;
+    if (analysis == AnalysisType::TRANSIENT) {
+        for (int k = 0; k * t_step <= t_stop * (1.0 + 1e-12); ++k) {
+            points.push_back(k * t_step);
+        }
+    } else if (analysis == AnalysisType::AC_SWEEP) {
+        for (int i = 0; i < ac_points; ++i) {
+            double f = (sweep_type == "Linear")
+                ? f_start + i * (f_stop - f_start) / max(1, ac_points - 1)
+                : f_start * pow(f_stop / f_start, (double)i / max(1, ac_points - 1));
+            points.push_back(f);
+        }
+    } else {
+        points.push_back(0.0);
+    }
+    return points;
+}
+
+void AnalysisRequest::run(Circuit& circuit, bool warmStart) const {
+    if (analysis == AnalysisType::TRANSIENT) {
+        transientAnalysis(circuit, t_step, t_stop);
+    } else if (analysis == AnalysisType::AC_SWEEP) {
+        acSweepAnalysis(circuit, acSource, f_start, f_stop, ac_points, sweep_type);
+    } else {
+        dcAnalysis(circuit, DiodeSolverType::RELAXATION, warmStart);
+    }
+}
+
+bool AnalysisRequest::sample(Circuit& circuit, const vector<string>& outputs, const vector<double>& axis, double* values) const {
+    bool ok = true;
+    const size_t num_points = axis.size();
+    for (size_t o = 0; o < outputs.size(); ++o) {
+        Node* node = circuit.findNode(outputs[o]);
+        for (size_t p = 0; p < num_points; ++p) {
+            double value;
+            if (!node) value = numeric_limits<double>::quiet_NaN();
+            else if (analysis == AnalysisType::TRANSIENT) value = sampleHistory(node->voltage_history, axis[p]);
+            else if (analysis == AnalysisType::AC_SWEEP) value = sampleHistory(node->ac_sweep_history, axis[p]);
+            else value = node->getVoltage();
+            if (!isfinite(value)) ok = false;
+            values[o * num_points + p] = value;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,386 @@
+#include "BatchSimulator.h"
+#include "LinearSolver.h"
+#include "CompanionModel.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+const int W = BATCH_LANES;
+
+// Dense structure-of-arrays LU of W same-size matrices: entry (i, j) of lane l
+// is a[(i * N + j) * W + l], so every inner loop runs over the W lanes of one
+// entry and vectorizes. All lanes share one pivot sequence, chosen on their
+// summed magnitudes; a lane whose pivot falls below PIVOT_THRESHOLD of its own
+// column is refactored alone with partial pivoting.
+class LaneLU {
+public:
+    explicit LaneLU(int n) : N(n), a((size_t)n * n * W, 0.0), pivots(n), scalarLane(W, 0), scalar(W) {}
+
+    double* entry(int i, int j) { return &a[((size_t)i * N + j) * W]; }
+    const double* entry(int i, int j) const { return &a[((size_t)i * N + j) * W]; }
+
+    void factor(int lanes) {
+        const double PIVOT_THRESHOLD = 1e-3;
+        const vector<double> original = a;
+        fill(scalarLane.begin(), scalarLane.end(), 0);
+
+        for (int k = 0; k < N; ++k) {
+            int p = k;
+            double best = -1.0;
+            for (int r = k; r < N; ++r) {
+                const double* v = entry(r, k);
+                double sum = 0.0;
+                for (int l = 0; l < W; ++l) {
+                    if (!scalarLane[l]) sum += abs(v[l]);
+                }
+                if (sum > best) {
+                    best = sum;
+                    p = r;
+                }
+            }
+            pivots[k] = p;
+            if (p != k) swap_ranges(entry(k, 0), entry(k, 0) + (size_t)N * W, entry(p, 0));
+
+            double inv[W];
+            const double* pivot = entry(k, k);
+            for (int l = 0; l < W; ++l) {
+                double column_max = 0.0;
+                for (int r = k; r < N; ++r) column_max = max(column_max, abs(entry(r, k)[l]));
+                if (column_max == 0.0 || abs(pivot[l]) < PIVOT_THRESHOLD * column_max) scalarLane[l] = 1;
+                inv[l] = pivot[l] != 0.0 ? 1.0 / pivot[l] : 0.0;
+            }
+
+            const double* pivot_row = entry(k, 0);
+            for (int r = k + 1; r < N; ++r) {
+                double* row = entry(r, 0);
+                double m[W];
+                bool any = false;
+                for (int l = 0; l < W; ++l) {
+                    m[l] = row[k * W + l] * inv[l];
+                    any |= (m[l] != 0.0);
+                }
+                if (!any) continue; // MNA rows are sparse; most have nothing to eliminate
+                for (int l = 0; l < W; ++l) row[k * W + l] = m[l];
+                for (int j = k + 1; j < N; ++j) {
+                    double* dst = row + (size_t)j * W;
+                    const double* src = pivot_row + (size_t)j * W;
+                    for (int l = 0; l < W; ++l) dst[l] -= m[l] * src[l];
+                }
+            }
+        }
+
+        for (int l = 0; l < lanes; ++l) {
+            if (!scalarLane[l]) continue;
+            vector<vector<double>> lane(N, vector<double>(N));
+            for (int i = 0; i < N; ++i) {
+                for (int j = 0; j < N; ++j) lane[i][j] = original[((size_t)i * N + j) * W + l];
+            }
+            scalar[l] = luFactorize(move(lane));
+        }
+    }
+
+    // b and x hold N x W values, unknown-major like the matrix entries
+    void solve(const vector<double>& b, vector<double>& x, int lanes) const {
+        x = b;
+        for (int k = 0; k < N; ++k) {
+            if (pivots[k] != k) swap_ranges(&x[(size_t)k * W], &x[(size_t)(k + 1) * W], &x[(size_t)pivots[k] * W]);
+        }
+        for (int r = 0; r < N; ++r) {
+            double* xr = &x[(size_t)r * W];
+            for (int k = 0; k < r; ++k) {
+                const double* L = entry(r, k);
+                const double* xk = &x[(size_t)k * W];
+                for (int l = 0; l < W; ++l) xr[l] -= L[l] * xk[l];
+            }
+        }
+        for (int r = N - 1; r >= 0; --r) {
+            double* xr = &x[(size_t)r * W];
+            for (int j = r + 1; j < N; ++j) {
+                const double* U = entry(r, j);
+                const double* xj = &x[(size_t)j * W];
+                for (int l = 0; l < W; ++l) xr[l] -= U[l] * xj[l];
+            }
+            const double* d = entry(r, r);
+            for (int l = 0; l < W; ++l) xr[l] /= d[l];
+        }
+
+        for (int l = 0; l < lanes; ++l) {
+            if (!scalarLane[l]) continue;
+            vector<double> lane_b(N);
+            for (int i = 0; i < N; ++i) lane_b[i] = b[(size_t)i * W + l];
+            vector<double> lane_x = luSolve(scalar[l], lane_b);
+            for (int i = 0; i < N; ++i) x[(size_t)i * W + l] = lane_x[i];
+        }
+    }
+
+    int N;
+    vector<double> a;
+    vector<int> pivots;       // Row swapped with row k at step k
+    vector<char> scalarLane;  // Lanes solved through their own factorization
+    vector<LUFactorization> scalar;
+};
+
+// Unknowns are ordered as in the scalar DC/transient MNA system:
+// non-ground nodes, voltage source currents, inductor currents
+struct BatchTopology : CompanionTopology {
+    explicit BatchTopology(const Circuit& circuit) {
+        auto terminals = [&](const Component& c) {
+            return Terminals{circuit.getNodeMatrixIndex(c.node1), circuit.getNodeMatrixIndex(c.node2)};
+        };
+        n = circuit.countNonGroundNodes();
+        for (const auto& c : circuit.resistors) resistors.push_back(terminals(c));
+        for (const auto& c : circuit.capacitors) capacitors.push_back(terminals(c));
+        for (const auto& c : circuit.inductors) inductors.push_back(terminals(c));
+        for (const auto& c : circuit.voltageSources) voltageSources.push_back(terminals(c));
+        for (const auto& c : circuit.currentSources) currentSources.push_back(terminals(c));
+        N = n + voltageSources.size() + inductors.size();
+    }
+};
+
+// One value per lane
+struct Lanes {
+    double v[W];
+};
+
+Lanes operator*(const Lanes& a, const Lanes& b) {
+    Lanes r;
+    for (int l = 0; l < W; ++l) r.v[l] = a.v[l] * b.v[l];
+    return r;
+}
+
+Lanes operator*(const Lanes& a, double s) {
+    Lanes r;
+    for (int l = 0; l < W; ++l) r.v[l] = a.v[l] * s;
+    return r;
+}
+
+Lanes operator-(const Lanes& a) {
+    return a * -1.0;
+}
+
+// Component values of one lane group: entry [component * W + lane]
+struct LaneValues {
+    vector<double> resistance, capacitance, inductance, voltage, current;
+};
+
+// LaneValues and the previous step's state, as stampCompanionMatrix/RHS read them
+struct LaneStamp {
+    const LaneValues& v;
+    const vector<double>& capState;
+    const vector<double>& indState;
+
+    static Lanes at(const vector<double>& src, size_t i) {
+        Lanes r;
+        copy(&src[i * W], &src[i * W] + W, r.v);
+        return r;
+    }
+    Lanes conductance(size_t i) const {
+        Lanes r;
+        for (int l = 0; l < W; ++l) r.v[l] = 1.0 / v.resistance[i * W + l];
+        return r;
+    }
+    Lanes capacitance(size_t i) const { return at(v.capacitance, i); }
+    Lanes inductance(size_t i) const { return at(v.inductance, i); }
+    Lanes voltage(size_t i) const { return at(v.voltage, i); }
+    Lanes current(size_t i) const { return at(v.current, i); }
+    Lanes capVoltage(size_t i) const { return at(capState, i); }
+    Lanes indCurrent(size_t i) const { return at(indState, i); }
+};
+
+struct LaneMatrix {
+    LaneLU& lu;
+    void add(int i, int j, const Lanes& g) {
+        for (int l = 0; l < W; ++l) lu.entry(i, j)[l] += g.v[l];
+    }
+    void add(int i, int j, double g) {
+        for (int l = 0; l < W; ++l) lu.entry(i, j)[l] += g;
+    }
+    void set(int i, int j, double value) { fill(lu.entry(i, j), lu.entry(i, j) + W, value); }
+};
+
+struct LaneVector {
+    vector<double>& b;
+    void add(size_t i, const Lanes& value) {
+        for (int l = 0; l < W; ++l) b[i * W + l] += value.v[l];
+    }
+};
+
+// Backward Euler companion system with step h, as Circuit::set_MNA_A builds it
+void assemble(LaneLU& lu, const BatchTopology& t, const LaneValues& v, double h) {
+    fill(lu.a.begin(), lu.a.end(), 0.0);
+    const vector<double> none;
+    LaneMatrix A{lu};
+    stampCompanionMatrix(t, h, LaneStamp{v, none, none}, A);
+}
+
+// Right-hand side for step h from the capacitor voltages and inductor currents
+// at the end of the previous step
+void assembleRHS(vector<double>& b, const BatchTopology& t, const LaneValues& v, double h,
+                 const vector<double>& capVoltage, const vector<double>& indCurrent) {
+    fill(b.begin(), b.end(), 0.0);
+    LaneVector rhs{b};
+    stampCompanionRHS(t, h, LaneStamp{v, capVoltage, indCurrent}, rhs);
+}
+
+} // namespace
+
+bool isBatchable(const Circuit& circuit) {
+    return circuit.diodes.empty();
+}
+
+bool batchedAnalysis(const Circuit& circuit, const AnalysisRequest& request,
+                     const vector<string>& parameters, const vector<vector<double>>& values,
+                     const vector<string>& outputs,
+                     vector<vector<double>>& samples, vector<char>& ok) {
+    samples.assign(values.size(), {});
+    ok.assign(values.size(), 0);
+    if (!isBatchable(circuit) || request.analysis == AnalysisType::AC_SWEEP) return false;
+
+    // Parameter p writes vectors[p][index * W + lane]; AC magnitudes do not enter DC or transient
+    LaneValues nominal;
+    for (const auto& c : circuit.resistors) nominal.resistance.push_back(c.resistance);
+    for (const auto& c : circuit.capacitors) nominal.capacitance.push_back(c.capacitance);
+    for (const auto& c : circuit.inductors) nominal.inductance.push_back(c.inductance);
+    for (const auto& c : circuit.voltageSources) nominal.voltage.push_back(c.value);
+    for (const auto& c : circuit.currentSources) nominal.current.push_back(c.value);
+
+    struct Target {
+        vector<double> LaneValues::* values;
+        size_t index;
+    };
+    vector<Target> targets;
+    for (const auto& name : parameters) {
+        Target target{nullptr, 0};
+        auto find = [&](const auto& components, vector<double> LaneValues::* field) {
+            for (size_t i = 0; i < components.size(); ++i) {
+                if (components[i].name == name) target = {field, i};
+            }
+        };
+        find(circuit.resistors, &LaneValues::resistance);
+        find(circuit.capacitors, &LaneValues::capacitance);
+        find(circuit.inductors, &LaneValues::inductance);
+        find(circuit.voltageSources, &LaneValues::voltage);
+        find(circuit.currentSources, &LaneValues::current);
+        bool ac_source = any_of(circuit.acVoltageSources.begin(), circuit.acVoltageSources.end(),
+                                [&](const ACVoltageSource& s) { return s.name == name; });
+        if (!target.values && !ac_source) return false;
+        targets.push_back(target);
+    }
+
+    vector<int> outputIndex;
+    for (const auto& name : outputs) {
+        auto it = find_if(circuit.nodes.begin(), circuit.nodes.end(), [&](const Node* n) { return n->name == name; });
+        if (it == circuit.nodes.end()) return false;
+        outputIndex.push_back(circuit.getNodeMatrixIndex(*it));
+    }
+
+    BatchTopology topology(circuit);
+    const int N = topology.N;
+    if (N == 0) return false;
+
+    const vector<double> axis = request.axis();
+    const size_t num_points = axis.size();
+    const size_t num_outputs = outputs.size();
+
+    // The same graph checks as the scalar analyses; values do not change the
+    // graph, so one check covers every lane. A rejected circuit fails them all.
+    const bool transient = request.analysis == AnalysisType::TRANSIENT;
+    TopologyReport checked = checkTopology(circuit, request.analysis);
+    TopologyReport operatingPoint = transient ? checkTopology(circuit, AnalysisType::DC, true) : checked;
+    if (checked.rejected) {
+        for (size_t k = 0; k < values.size(); ++k) {
+            samples[k].assign(num_outputs * num_points, numeric_limits<double>::quiet_NaN());
+        }
+        return true;
+    }
+    BatchTopology dcTopology = topology;
+    dcTopology.shuntNodes = operatingPoint.shuntNodes;
+    dcTopology.shuntConductance = operatingPoint.shuntConductance;
+    topology.shuntNodes = checked.shuntNodes;
+    topology.shuntConductance = checked.shuntConductance;
+    const double DC_STEP = 1e12; // Same companion step as dcAnalysis: capacitors open, inductors shorted
+
+    for (size_t start = 0; start < values.size(); start += W) {
+        const int lanes = min<int>(W, values.size() - start);
+
+        // Unused lanes repeat lane 0 so they stay finite
+        LaneValues v;
+        auto spread = [&](const vector<double>& src, vector<double>& dst) {
+            dst.resize(src.size() * W);
+            for (size_t i = 0; i < src.size(); ++i) fill(&dst[i * W], &dst[i * W] + W, src[i]);
+        };
+        spread(nominal.resistance, v.resistance);
+        spread(nominal.capacitance, v.capacitance);
+        spread(nominal.inductance, v.inductance);
+        spread(nominal.voltage, v.voltage);
+        spread(nominal.current, v.current);
+        for (int l = 0; l < W; ++l) {
+            const vector<double>& lane_values = values[start + (l < lanes ? l : 0)];
+            for (size_t p = 0; p < targets.size() && p < lane_values.size(); ++p) {
+                if (targets[p].values) (v.*targets[p].values)[targets[p].index * W + l] = lane_values[p];
+            }
+        }
+        for (int l = 0; l < lanes; ++l) samples[start + l].assign(num_outputs * num_points, 0.0);
+
+        auto record = [&](const vector<double>& x, size_t point) {
+            for (size_t o = 0; o < num_outputs; ++o) {
+                if (outputIndex[o] < 0) continue; // Ground stays at 0 V
+                for (int l = 0; l < lanes; ++l) {
+                    samples[start + l][o * num_points + point] = x[(size_t)outputIndex[o] * W + l];
+                }
+            }
+        };
+
+        LaneLU lu(N);
+        vector<double> b(N * W), x(N * W);
+        vector<double> capVoltage(topology.capacitors.size() * W, 0.0);
+        vector<double> indCurrent(topology.inductors.size() * W, 0.0);
+
+        if (operatingPoint.rejected) {
+            // A DC-only inductor loop: the transient starts from zero, as transientOperatingPoint does
+            fill(x.begin(), x.end(), 0.0);
+        } else {
+            assemble(lu, dcTopology, v, DC_STEP);
+            lu.factor(lanes);
+            assembleRHS(b, dcTopology, v, DC_STEP, capVoltage, indCurrent);
+            lu.solve(b, x, lanes);
+        }
+        record(x, 0);
+
+        if (transient && num_points > 1) {
+            // transientAnalysis starts integrating from zero capacitor voltages and
+            // inductor currents; with no diodes the step matrix never changes
+            const double h = request.t_step;
+            assemble(lu, topology, v, h);
+            lu.factor(lanes);
+            for (size_t k = 1; k < num_points; ++k) {
+                assembleRHS(b, topology, v, h, capVoltage, indCurrent);
+                lu.solve(b, x, lanes);
+                record(x, k);
+
+                for (size_t i = 0; i < topology.capacitors.size(); ++i) {
+                    const Terminals& c = topology.capacitors[i];
+                    for (int l = 0; l < W; ++l) {
+                        double v1 = c.n1 != -1 ? x[(size_t)c.n1 * W + l] : 0.0;
+                        double v2 = c.n2 != -1 ? x[(size_t)c.n2 * W + l] : 0.0;
+                        capVoltage[i * W + l] = v1 - v2;
+                    }
+                }
+                for (size_t i = 0; i < topology.inductors.size(); ++i) {
+                    size_t k_ind = topology.n + topology.voltageSources.size() + i;
+                    copy(&x[k_ind * W], &x[k_ind * W] + W, &indCurrent[i * W]);
+                }
+            }
+        }
+
+        for (int l = 0; l < lanes; ++l) {
+            const auto& s = samples[start + l];
+            ok[start + l] = all_of(s.begin(), s.end(), [](double value) { return isfinite(value); });
+        }
+    }
+    return true;
+}
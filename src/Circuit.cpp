@@ -1,10 +1,11 @@
 #include "Circuit.h"
+#include "Fingerprint.h"
 #include <algorithm>
 #include <vector>
 #include <string>
 #include <complex>
 
-Circuit::Circuit() : delta_t(0) {}
+Circuit::Circuit() : delta_t(0), gmin(0.0), sourceScale(1.0) {}
 
 Circuit::~Circuit() {
     for (Node *node: nodes) {
@@ -13,6 +14,68 @@ Circuit::~Circuit() {
     nodes.clear();
 }
 
+Circuit::Circuit(const Circuit &other) : Circuit() {
+    *this = other;
+}
+
+Circuit &Circuit::operator=(const Circuit &other) {
+    if (this == &other) return *this;
+
+    for (Node *node: nodes) {
+        delete node;
+    }
+    nodes.clear();
+
+    map<const Node *, Node *> remap;
+    for (const Node *node: other.nodes) {
+        Node *copy = new Node(*node);
+        nodes.push_back(copy);
+        remap[node] = copy;
+    }
+    auto relink = [&](Component &component) {
+        component.node1 = component.node1 ? remap[component.node1] : nullptr;
+        component.node2 = component.node2 ? remap[component.node2] : nullptr;
+    };
+
+    resistors = other.resistors;
+    capacitors = other.capacitors;
+    inductors = other.inductors;
+    diodes = other.diodes;
+    voltageSources = other.voltageSources;
+    acVoltageSources = other.acVoltageSources;
+    currentSources = other.currentSources;
+    for (auto &c: resistors) relink(c);
+    for (auto &c: capacitors) relink(c);
+    for (auto &c: inductors) relink(c);
+    for (auto &c: diodes) relink(c);
+    for (auto &c: voltageSources) relink(c);
+    for (auto &c: currentSources) relink(c);
+    for (auto &src: acVoltageSources) {
+        src.node1 = src.node1 ? remap[src.node1] : nullptr;
+        src.node2 = src.node2 ? remap[src.node2] : nullptr;
+    }
+
+    groundNodeNames = other.groundNodeNames;
+    delta_t = other.delta_t;
+    gmin = other.gmin;
+    sourceScale = other.sourceScale;
+    MNA_A = other.MNA_A;
+    MNA_RHS = other.MNA_RHS;
+    MNA_solution = other.MNA_solution;
+    MNA_A_Complex = other.MNA_A_Complex;
+    MNA_RHS_Complex = other.MNA_RHS_Complex;
+    acResult = other.acResult;
+    acReducedModel = other.acReducedModel;
+    operatingPoint = other.operatingPoint;
+    topology = other.topology;
+    componentVariations = other.componentVariations;
+    monteCarloResult = other.monteCarloResult;
+    acPattern = other.acPattern;
+    stepParameters = other.stepParameters;
+    parameterSweepResult = other.parameterSweepResult;
+    return *this;
+}
+
 void Circuit::addNode(const string &name) {
     if (!findNode(name)) {
         Node *newNode = new Node();
@@ -70,6 +133,21 @@ VoltageSource *Circuit::findVoltageSource(const string &find_from_name) {
     return nullptr;
 }
 
+ACVoltageSource *Circuit::findACVoltageSource(const string &find_from_name) {
+    for (auto &vs: acVoltageSources) { if (vs.name == find_from_name) return &vs; }
+    return nullptr;
+}
+
+double *Circuit::findComponentValue(const string &name) {
+    if (Resistor *r = findResistor(name)) return &r->resistance;
+    if (Capacitor *c = findCapacitor(name)) return &c->capacitance;
+    if (Inductor *l = findInductor(name)) return &l->inductance;
+    if (VoltageSource *vs = findVoltageSource(name)) return &vs->value;
+    if (CurrentSource *cs = findCurrentSource(name)) return &cs->value;
+    if (ACVoltageSource *ac = findACVoltageSource(name)) return &ac->magnitude;
+    return nullptr;
+}
+
 bool Circuit::deleteResistor(const string &name) {
     auto it = remove_if(resistors.begin(), resistors.end(), [&](const Resistor &r) { return r.name == name; });
     if (it != resistors.end()) {
@@ -155,21 +233,69 @@ vector<vector<double>> Circuit::G() {
     for (const auto& res : resistors) {
         int n1_index = getNodeMatrixIndex(res.node1);
         int n2_index = getNodeMatrixIndex(res.node2);
-        
+        if (n1_index == n2_index) continue; // Skip if both terminals on same node
+
+        double g = 1.0 / res.resistance;
+        if (n1_index != -1) {
+            result[n1_index][n1_index] += g;
+        }
+        if (n2_index != -1) {
+            result[n2_index][n2_index] += g;
+        }
         if (n1_index != -1 && n2_index != -1) {
-            double g = 1.0 / res.resistance;
-            if (n1_index == n2_index) continue; // Skip if both terminals on same node
-            
-            if (n1_index != -1) {
-                result[n1_index][n1_index] += g;
-            }
-            if (n2_index != -1) {
-                result[n2_index][n2_index] += g;
-            }
-            if (n1_index != -1 && n2_index != -1) {
-                result[n1_index][n2_index] -= g;
-                result[n2_index][n1_index] -= g;
-            }
+            result[n1_index][n2_index] -= g;
+            result[n2_index][n1_index] -= g;
+        }
+    }
+
+    // Continuation shunt from every node to ground
+    if (gmin > 0.0) {
+        for (int i = 0; i < n; ++i) {
+            result[i][i] += gmin;
+        }
+    }
+
+    // Floating nodes the topology check tied to ground
+    for (int i : topology.shuntNodes) {
+        if (i < n) result[i][i] += topology.shuntConductance;
+    }
+
+    // Exponential diodes contribute the conductance of their Newton-Raphson companion model
+    for (const auto& d : diodes) {
+        if (d.getModel() != MODEL_SHOCKLEY) continue;
+        int n1_index = getNodeMatrixIndex(d.node1);
+        int n2_index = getNodeMatrixIndex(d.node2);
+        if (n1_index == n2_index) continue;
+
+        double g = d.companionConductance;
+        if (n1_index != -1) {
+            result[n1_index][n1_index] += g;
+        }
+        if (n2_index != -1) {
+            result[n2_index][n2_index] += g;
+        }
+        if (n1_index != -1 && n2_index != -1) {
+            result[n1_index][n2_index] -= g;
+            result[n2_index][n1_index] -= g;
+        }
+    }
+
+    // Capacitors contribute their backward Euler companion conductance C/dt
+    for (const auto& cap : capacitors) {
+        int n1_index = getNodeMatrixIndex(cap.node1);
+        int n2_index = getNodeMatrixIndex(cap.node2);
+        if (n1_index == n2_index) continue;
+
+        double g = cap.capacitance / delta_t;
+        if (n1_index != -1) {
+            result[n1_index][n1_index] += g;
+        }
+        if (n2_index != -1) {
+            result[n2_index][n2_index] += g;
+        }
+        if (n1_index != -1 && n2_index != -1) {
+            result[n1_index][n2_index] -= g;
+            result[n2_index][n1_index] -= g;
         }
     }
     
@@ -210,6 +336,21 @@ vector<vector<double>> Circuit::B() {
             result[n2_index][ind_index] = -1.0;
         }
     }
+
+    // Conducting diodes behave as voltage sources and contribute to B matrix
+    for (const auto& d : diodes) {
+        int branch_index = d.getBranchIndex();
+        if (branch_index < 0 || branch_index >= extra_vars) continue;
+        int n1_index = getNodeMatrixIndex(d.node1);
+        int n2_index = getNodeMatrixIndex(d.node2);
+
+        if (n1_index != -1) {
+            result[n1_index][branch_index] = 1.0;
+        }
+        if (n2_index != -1) {
+            result[n2_index][branch_index] = -1.0;
+        }
+    }
     
     return result;
 }
@@ -248,6 +389,21 @@ vector<vector<double>> Circuit::C() {
             result[ind_index][n2_index] = -1.0;
         }
     }
+
+    // Conducting diodes contribute to C matrix (transpose of B)
+    for (const auto& d : diodes) {
+        int branch_index = d.getBranchIndex();
+        if (branch_index < 0 || branch_index >= extra_vars) continue;
+        int n1_index = getNodeMatrixIndex(d.node1);
+        int n2_index = getNodeMatrixIndex(d.node2);
+
+        if (n1_index != -1) {
+            result[branch_index][n1_index] = 1.0;
+        }
+        if (n2_index != -1) {
+            result[branch_index][n2_index] = -1.0;
+        }
+    }
     
     return result;
 }
@@ -256,15 +412,15 @@ vector<vector<double>> Circuit::D() {
     int extra_vars = countTotalExtraVariables();
     vector<vector<double>> result(extra_vars, vector<double>(extra_vars, 0.0));
     
-    // Diodes in forward or reverse conducting state contribute to D matrix
-    for (const auto& d : diodes) {
-        if (d.getState() == DiodeState::STATE_FORWARD_ON || d.getState() == DiodeState::STATE_REVERSE_ON) {
-            int branch_index = d.getBranchIndex();
-            if (branch_index >= 0 && branch_index < extra_vars) {
-                result[branch_index][branch_index] = 1.0; // Diode current unknown, so placeholder
-            }
+    // Inductors: v_L(n+1) - L/dt * i_L(n+1) = -L/dt * i_L(n) (backward Euler)
+    for (size_t i = 0; i < inductors.size(); ++i) {
+        int ind_index = voltageSources.size() + i;
+        if (ind_index < extra_vars) {
+            result[ind_index][ind_index] = -inductors[i].inductance / delta_t;
         }
     }
+
+    // Conducting diodes are ideal voltage sources and leave their D entries at zero
     
     return result;
 }
@@ -275,7 +431,7 @@ vector<double> Circuit::J() {
     
     // Voltage sources contribute to J vector
     for (size_t i = 0; i < voltageSources.size(); ++i) {
-        result[i] = voltageSources[i].value;
+        result[i] = voltageSources[i].value * sourceScale;
     }
     
     // Inductors contribute to J vector
@@ -288,6 +444,17 @@ vector<double> Circuit::J() {
             result[ind_index] = -inductors[i].inductance / delta_t * inductors[i].prevCurrent;
         }
     }
+
+    // Conducting diodes hold their forward or zener voltage across the junction
+    for (const auto& d : diodes) {
+        int branch_index = d.getBranchIndex();
+        if (branch_index < 0 || branch_index >= extra_vars) continue;
+        if (d.getState() == STATE_FORWARD_ON) {
+            result[branch_index] = d.getForwardVoltage();
+        } else if (d.getState() == STATE_REVERSE_ON) {
+            result[branch_index] = -d.getZenerVoltage();
+        }
+    }
     
     return result;
 }
@@ -302,18 +469,32 @@ vector<double> Circuit::E() {
         int n2_index = getNodeMatrixIndex(cs.node2);
         
         if (n1_index != -1) {
-            result[n1_index] += cs.value;
+            result[n1_index] += cs.value * sourceScale;
         }
         if (n2_index != -1) {
-            result[n2_index] -= cs.value;
+            result[n2_index] -= cs.value * sourceScale;
         }
     }
     
-    // Capacitors contribute to E vector
+    // Exponential diodes: the companion current source drives anode -> cathode
+    for (const auto& d : diodes) {
+        if (d.getModel() != MODEL_SHOCKLEY) continue;
+        int n1_index = getNodeMatrixIndex(d.node1);
+        int n2_index = getNodeMatrixIndex(d.node2);
+
+        if (n1_index != -1) {
+            result[n1_index] -= d.companionCurrent;
+        }
+        if (n2_index != -1) {
+            result[n2_index] += d.companionCurrent;
+        }
+    }
+
+    // Capacitors contribute the history current C/dt * v_C(n) of their companion model
     for (const auto& cap : capacitors) {
         int n1_index = getNodeMatrixIndex(cap.node1);
         int n2_index = getNodeMatrixIndex(cap.node2);
-        double i_cap = cap.capacitance / delta_t * (cap.node1->getVoltage() - cap.node2->getVoltage() - cap.prevVoltage);
+        double i_cap = cap.capacitance / delta_t * cap.prevVoltage;
         
         if (n1_index != -1) {
             result[n1_index] += i_cap;
@@ -326,73 +507,213 @@ vector<double> Circuit::E() {
     return result;
 }
 
-// --- MODIFIED ---
-// This function is now a dispatcher. It builds the correct MNA matrix
-// based on the analysis type.
-void Circuit::set_MNA_A(AnalysisType type, double frequency) {
-    if (type == AnalysisType::AC_SWEEP) {
-        // --- NEW LOGIC FOR AC ANALYSIS ---
-        int n = countNonGroundNodes();
-        // For simplicity, this example assumes only voltage sources add extra variables in AC
-        int m = acVoltageSources.size();
-        MNA_A_Complex.assign(n + m, vector<complex<double>>(n + m, {0.0, 0.0}));
-
-        // G Matrix (Resistors)
-        for (const auto &res : resistors) {
-            double conductance = 1.0 / res.resistance;
-            int idx1 = getNodeMatrixIndex(res.node1);
-            int idx2 = getNodeMatrixIndex(res.node2);
-            if (idx1 != -1) MNA_A_Complex[idx1][idx1] += conductance;
-            if (idx2 != -1) MNA_A_Complex[idx2][idx2] += conductance;
-            if (idx1 != -1 && idx2 != -1) {
-                MNA_A_Complex[idx1][idx2] -= conductance;
-                MNA_A_Complex[idx2][idx1] -= conductance;
-            }
+void ACSystemParts::form(double omega, vector<vector<complex<double>>>& A) const {
+    for (const auto& entry : nonzeros) {
+        int r = entry.first;
+        int c = entry.second;
+        A[r][c] = complex<double>(G[r][c], omega * C[r][c] - Gamma[r][c] / omega);
+    }
+}
+
+void ACSystemParts::formEntries(double omega, vector<complex<double>>& entries) const {
+    entries.resize(nonzeros.size());
+    for (size_t e = 0; e < nonzeros.size(); ++e) {
+        int r = nonzeros[e].first;
+        int c = nonzeros[e].second;
+        entries[e] = complex<double>(G[r][c], omega * C[r][c] - Gamma[r][c] / omega);
+    }
+}
+
+// Splits the AC system into the parts that scale with w and 1/w. Only reads
+// circuit data, so concurrent sweeps can share one circuit.
+void Circuit::buildACSystemParts(ACSystemParts& parts) const {
+    int n = countNonGroundNodes();
+    // Extra variables: AC sources, DC voltage sources (shorts for small signals)
+    // and ideal diodes conducting at the operating point (shorts as well)
+    bool biased = operatingPoint.valid && operatingPoint.diodeStates.size() == diodes.size();
+    int conducting = 0;
+    for (size_t i = 0; biased && i < diodes.size(); ++i) {
+        if (diodes[i].getModel() == MODEL_IDEAL && operatingPoint.diodeStates[i] != STATE_OFF) conducting++;
+    }
+    int m = acVoltageSources.size() + voltageSources.size() + conducting;
+    parts.G.assign(n + m, vector<double>(n + m, 0.0));
+    parts.C.assign(n + m, vector<double>(n + m, 0.0));
+    parts.Gamma.assign(n + m, vector<double>(n + m, 0.0));
+
+    auto stamp = [&](vector<vector<double>>& M, const Node* n1, const Node* n2, double value) {
+        int idx1 = getNodeMatrixIndex(n1);
+        int idx2 = getNodeMatrixIndex(n2);
+        if (idx1 != -1) M[idx1][idx1] += value;
+        if (idx2 != -1) M[idx2][idx2] += value;
+        if (idx1 != -1 && idx2 != -1) {
+            M[idx1][idx2] -= value;
+            M[idx2][idx1] -= value;
+        }
+    };
+    auto stampBranch = [&](const Node* n1, const Node* n2, int var_idx) {
+        int idx1 = getNodeMatrixIndex(n1);
+        int idx2 = getNodeMatrixIndex(n2);
+        if (idx1 != -1) {
+            parts.G[idx1][var_idx] += 1.0;
+            parts.G[var_idx][idx1] += 1.0;
         }
+        if (idx2 != -1) {
+            parts.G[idx2][var_idx] -= 1.0;
+            parts.G[var_idx][idx2] -= 1.0;
+        }
+    };
 
-        // Impedances for L and C
-        const complex<double> j(0.0, 1.0);
-        for (const auto &cap : capacitors) {
-            complex<double> impedance = 1.0 / (j * 2.0 * M_PI * frequency * cap.capacitance);
-            complex<double> admittance = 1.0 / impedance;
-            int idx1 = getNodeMatrixIndex(cap.node1);
-            int idx2 = getNodeMatrixIndex(cap.node2);
-            if (idx1 != -1) MNA_A_Complex[idx1][idx1] += admittance;
-            if (idx2 != -1) MNA_A_Complex[idx2][idx2] += admittance;
-            if (idx1 != -1 && idx2 != -1) {
-                MNA_A_Complex[idx1][idx2] -= admittance;
-                MNA_A_Complex[idx2][idx1] -= admittance;
-            }
+    // G Matrix (Resistors)
+    for (const auto &res : resistors) {
+        stamp(parts.G, res.node1, res.node2, 1.0 / res.resistance);
+    }
+
+    for (int i : topology.shuntNodes) {
+        if (i < n) parts.G[i][i] += topology.shuntConductance;
+    }
+
+    // Exponential diodes: small-signal conductance at the operating point
+    for (size_t i = 0; biased && i < diodes.size(); ++i) {
+        if (diodes[i].getModel() == MODEL_SHOCKLEY) {
+            stamp(parts.G, diodes[i].node1, diodes[i].node2, operatingPoint.diodeConductances[i]);
         }
+    }
 
-        for (const auto &ind : inductors) {
-            complex<double> impedance = j * 2.0 * M_PI * frequency * ind.inductance;
-            complex<double> admittance = 1.0 / impedance;
-            int idx1 = getNodeMatrixIndex(ind.node1);
-            int idx2 = getNodeMatrixIndex(ind.node2);
-            if (idx1 != -1) MNA_A_Complex[idx1][idx1] += admittance;
-            if (idx2 != -1) MNA_A_Complex[idx2][idx2] += admittance;
-            if (idx1 != -1 && idx2 != -1) {
-                MNA_A_Complex[idx1][idx2] -= admittance;
-                MNA_A_Complex[idx2][idx1] -= admittance;
-            }
+    // Admittances jwC and 1/(jwL), without the frequency factor
+    for (const auto &cap : capacitors) {
+        stamp(parts.C, cap.node1, cap.node2, cap.capacitance);
+    }
+    for (const auto &ind : inductors) {
+        stamp(parts.Gamma, ind.node1, ind.node2, 1.0 / ind.inductance);
+    }
+
+    // B, C, D matrices for AC sources, then the small-signal shorts
+    int var_idx = n;
+    for (const auto& src : acVoltageSources) {
+        stampBranch(src.node1, src.node2, var_idx++);
+    }
+    for (const auto& vs : voltageSources) {
+        stampBranch(vs.node1, vs.node2, var_idx++);
+    }
+    for (size_t i = 0; biased && i < diodes.size(); ++i) {
+        if (diodes[i].getModel() == MODEL_IDEAL && operatingPoint.diodeStates[i] != STATE_OFF) {
+            stampBranch(diodes[i].node1, diodes[i].node2, var_idx++);
         }
+    }
 
-        // B, C, D matrices for AC sources
-        for (size_t i = 0; i < acVoltageSources.size(); ++i) {
-            int idx1 = getNodeMatrixIndex(acVoltageSources[i].node1);
-            int idx2 = getNodeMatrixIndex(acVoltageSources[i].node2);
-            int var_idx = n + i;
-            if (idx1 != -1) {
-                MNA_A_Complex[idx1][var_idx] += 1.0;
-                MNA_A_Complex[var_idx][idx1] += 1.0;
+    parts.nonzeros.clear();
+    for (int r = 0; r < n + m; ++r) {
+        for (int c = 0; c < n + m; ++c) {
+            if (parts.G[r][c] != 0.0 || parts.C[r][c] != 0.0 || parts.Gamma[r][c] != 0.0) {
+                parts.nonzeros.push_back({r, c});
             }
-            if (idx2 != -1) {
-                MNA_A_Complex[idx2][var_idx] -= 1.0;
-                MNA_A_Complex[var_idx][idx2] -= 1.0;
+        }
+    }
+}
+
+// Current through a resistor, capacitor, inductor or exponential diode over the
+// last AC sweep, derived from its node voltage columns (node1 to node2).
+bool Circuit::acComponentCurrent(const string& name, vector<complex<double>>& current) const {
+    const Node* n1 = nullptr;
+    const Node* n2 = nullptr;
+    int kind = -1;
+    double value = 0.0;
+    for (const auto& res : resistors) {
+        if (res.name == name) { n1 = res.node1; n2 = res.node2; kind = 0; value = res.resistance; }
+    }
+    for (const auto& cap : capacitors) {
+        if (cap.name == name) { n1 = cap.node1; n2 = cap.node2; kind = 1; value = cap.capacitance; }
+    }
+    for (const auto& ind : inductors) {
+        if (ind.name == name) { n1 = ind.node1; n2 = ind.node2; kind = 2; value = ind.inductance; }
+    }
+    for (size_t i = 0; i < diodes.size() && i < operatingPoint.diodeConductances.size(); ++i) {
+        if (diodes[i].name == name && diodes[i].getModel() == MODEL_SHOCKLEY) {
+            n1 = diodes[i].node1; n2 = diodes[i].node2; kind = 0; value = 1.0 / operatingPoint.diodeConductances[i];
+        }
+    }
+    if (kind == -1) return false;
+
+    size_t count = acResult.pointCount();
+    int idx1 = getNodeMatrixIndex(n1);
+    int idx2 = getNodeMatrixIndex(n2);
+    if ((idx1 != -1 && idx1 >= (int)acResult.unknownCount()) || (idx2 != -1 && idx2 >= (int)acResult.unknownCount())) {
+        return false; // Circuit changed since the sweep
+    }
+
+    current.assign(count, {0.0, 0.0});
+    for (size_t i = 0; i < count; ++i) {
+        complex<double> v(0.0, 0.0);
+        if (idx1 != -1) v += acResult.column(idx1)[i];
+        if (idx2 != -1) v -= acResult.column(idx2)[i];
+        complex<double> jw(0.0, 2.0 * M_PI * acResult.frequencies[i]);
+        if (kind == 0) current[i] = v / value;
+        else if (kind == 1) current[i] = v * jw * value;
+        else current[i] = v / (jw * value);
+    }
+    return true;
+}
+
+// Names of the AC unknowns in matrix order: non-ground nodes, AC sources, DC
+// voltage sources, then ideal diodes conducting at the operating point.
+vector<string> Circuit::acUnknownNames() const {
+    vector<string> names;
+    for (const auto* node : nodes) {
+        if (!node->isGround) names.push_back(node->name);
+    }
+    for (const auto& src : acVoltageSources) names.push_back(src.name);
+    for (const auto& vs : voltageSources) names.push_back(vs.name);
+    if (operatingPoint.valid && operatingPoint.diodeStates.size() == diodes.size()) {
+        for (size_t i = 0; i < diodes.size(); ++i) {
+            if (diodes[i].getModel() == MODEL_IDEAL && operatingPoint.diodeStates[i] != STATE_OFF) {
+                names.push_back(diodes[i].name);
             }
         }
+    }
+    return names;
+}
+
+// Hash of everything the DC operating point depends on
+uint64_t Circuit::dcFingerprint() const {
+    Fingerprint hash;
+    auto mixNodes = [&](const Node* n1, const Node* n2) {
+        hash.mix(getNodeMatrixIndex(n1));
+        hash.mix(getNodeMatrixIndex(n2));
+    };
+    hash.mix(countNonGroundNodes());
+    for (const auto& res : resistors) { mixNodes(res.node1, res.node2); hash.mix(res.resistance); }
+    for (const auto& vs : voltageSources) { mixNodes(vs.node1, vs.node2); hash.mix(vs.value); }
+    for (const auto& cs : currentSources) { mixNodes(cs.node1, cs.node2); hash.mix(cs.value); }
+    for (const auto& cap : capacitors) { mixNodes(cap.node1, cap.node2); }
+    for (const auto& ind : inductors) { mixNodes(ind.node1, ind.node2); }
+    for (const auto& d : diodes) {
+        mixNodes(d.node1, d.node2);
+        hash.mix(d.getDiodeType());
+        hash.mix(d.getModel());
+        hash.mix(d.getForwardVoltage());
+        hash.mix(d.getZenerVoltage());
+        hash.mix(d.saturationCurrent);
+        hash.mix(d.emissionCoefficient);
+        hash.mix(d.breakdownCurrent);
+    }
+    return hash.value;
+}
 
+// Builds the complex AC system matrix into A.
+void Circuit::assembleACMatrix(double frequency, vector<vector<complex<double>>>& A) const {
+    ACSystemParts parts;
+    buildACSystemParts(parts);
+    int size = parts.G.size();
+    A.assign(size, vector<complex<double>>(size, {0.0, 0.0}));
+    parts.form(2.0 * M_PI * frequency, A);
+}
+
+// --- MODIFIED ---
+// This function is now a dispatcher. It builds the correct MNA matrix
+// based on the analysis type.
+void Circuit::set_MNA_A(AnalysisType type, double frequency) {
+    if (type == AnalysisType::AC_SWEEP) {
+        assembleACMatrix(frequency, MNA_A_Complex);
     } else {
         // --- EXISTING LOGIC FOR DC/TRANSIENT ---
         // (This is the original implementation using real numbers)
@@ -441,27 +762,31 @@ void Circuit::set_MNA_A(AnalysisType type, double frequency) {
     }
 }
 
+void Circuit::assembleACRHS(vector<complex<double>>& rhs) const {
+    int n = countNonGroundNodes();
+    int m = acUnknownNames().size() - n;
+    rhs.assign(n + m, {0.0, 0.0});
+
+    // E vector for AC sources
+    for (size_t i = 0; i < acVoltageSources.size(); ++i) {
+        rhs[n + i] = acVoltageSources[i].getPhasor();
+    }
+    // Note: AC current sources would contribute to the 'J' part of the vector
+}
+
 // The set_MNA_RHS function would be similarly modified to handle complex values for AC sources.
 void Circuit::set_MNA_RHS(AnalysisType type, double frequency) {
     if (type == AnalysisType::AC_SWEEP) {
-        int n = countNonGroundNodes();
-        int m = acVoltageSources.size();
-        MNA_RHS_Complex.assign(n + m, {0.0, 0.0});
-
-        // E vector for AC sources
-        for (size_t i = 0; i < acVoltageSources.size(); ++i) {
-            MNA_RHS_Complex[n + i] = acVoltageSources[i].getPhasor();
-        }
-        // Note: AC current sources would contribute to the 'J' part of the vector
+        assembleACRHS(MNA_RHS_Complex);
     } else {
-        // Original implementation for DC/Transient
-        vector<double> j_vec = J();
+        // Original implementation for DC/Transient: node currents (E) first, then branch voltages (J)
         vector<double> e_vec = E();
-        int n = j_vec.size();
-        int m = countTotalExtraVariables();
+        vector<double> j_vec = J();
+        int n = e_vec.size();
+        int m = j_vec.size();
         MNA_RHS.assign(n + m, 0.0);
-        for (int i = 0; i < n; i++) MNA_RHS[i] = j_vec[i];
-        for (int i = 0; i < m; i++) MNA_RHS[n + i] = e_vec[i];
+        for (int i = 0; i < n; i++) MNA_RHS[i] = e_vec[i];
+        for (int i = 0; i < m; i++) MNA_RHS[n + i] = j_vec[i];
     }
 }
 
@@ -474,6 +799,14 @@ void Circuit::setDeltaT(double dt) {
     this->delta_t = dt;
 }
 
+void Circuit::setGmin(double g) {
+    this->gmin = g;
+}
+
+void Circuit::setSourceScale(double scale) {
+    this->sourceScale = scale;
+}
+
 void Circuit::updateComponentStates() {
     for (auto &cap: capacitors) {
         cap.update(delta_t);
@@ -492,6 +825,15 @@ void Circuit::clearComponentHistory() {
     }
 }
 
+void Circuit::clearStoredResults() {
+    clearComponentHistory();
+    acResult.clear();
+    monteCarloResult = MonteCarloResult();
+    componentVariations.clear();
+    stepParameters.clear();
+    parameterSweepResult = ParameterSweepResult();
+}
+
 bool Circuit::isNodeNameGround(const string &node_name) const {
     for (const auto &gnd_name: groundNodeNames) {
         if (gnd_name == node_name) {
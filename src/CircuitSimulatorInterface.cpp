@@ -1,14 +1,139 @@
 #include "CircuitSimulatorInterface.h"
 #include "Analysis.h"
+#include "WaveformRelaxation.h"
+#include "SeriesReduction.h"
+#include "Topology.h"
 #include <cstring>
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+#ifndef _WIN32
+// Stand-in for strcpy_s: truncates to size - 1 characters and always terminates
+static inline void strcpy_s(char* dest, size_t size, const char* src) {
+    if (size == 0) return;
+    size_t length = std::min(std::strlen(src), size - 1);
+    std::memcpy(dest, src, length);
+    dest[length] = '\0';
+}
+#endif
+
+// Resolves an AC result column by name: a node voltage or AC source current is
+// read in place; a resistor, capacitor or inductor current is derived into scratch.
+static const std::complex<double>* findACColumn(const Circuit* c, const char* name, std::vector<std::complex<double>>& scratch) {
+    if (c->isNodeNameGround(name)) {
+        scratch.assign(c->acResult.pointCount(), {0.0, 0.0});
+        return scratch.data();
+    }
+    int k = c->acResult.findUnknown(name);
+    if (k != -1) return c->acResult.column(k);
+    if (c->acComponentCurrent(name, scratch)) return scratch.data();
+    return nullptr;
+}
+
+// Writes the comma-separated parameter names into buffer (left empty if it
+// does not fit)
+template <typename T>
+static void writeParameterNames(const std::vector<std::pair<std::string, T>>& entries, char* buffer, int bufferSize) {
+    if (!buffer || bufferSize <= 0) return;
+    std::stringstream ss;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i) ss << ",";
+        ss << entries[i].first;
+    }
+    std::string allNames = ss.str();
+    if (allNames.length() < static_cast<size_t>(bufferSize)) {
+        strcpy_s(buffer, bufferSize, allNames.c_str());
+    } else {
+        buffer[0] = '\0';
+    }
+}
+
+// Runs one analysis; a circuit its topology check rejected gets its own error
+// code instead of success with NaN results
+template <typename Run>
+static int runAnalysis(void* circuit, Run run) {
+    Circuit* c = static_cast<Circuit*>(circuit);
+    c->topology = TopologyReport();
+    try {
+        run(*c);
+    }
+    catch (...) {
+        return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+    }
+    return c->topology.rejected ? CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY : CIRCUIT_SIM_SUCCESS;
+}
+
+// Checks the graph once ahead of a batch driver, so a singular netlist fails
+// here rather than in every trial. The DC graph also matters for diode bias;
+// a transient ties its DC-only problems to ground instead.
+static bool topologyRejected(Circuit* c, AnalysisType type) {
+    c->topology = TopologyReport();
+    if (type == AnalysisType::DC || (type == AnalysisType::AC_SWEEP && !c->diodes.empty())) {
+        c->topology = checkTopology(*c, AnalysisType::DC);
+    }
+    if (!c->topology.rejected && type != AnalysisType::DC) c->topology = checkTopology(*c, type);
+    return c->topology.rejected;
+}
+
+// Runs Monte Carlo on the circuit's tolerances for comma-separated output nodes
+static int runMonteCarlo(void* circuit, const char* outputNodes, MonteCarloOptions& options) {
+    Circuit* c = static_cast<Circuit*>(circuit);
+    std::stringstream ss(outputNodes);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        if (!name.empty()) options.outputs.push_back(name);
+    }
+    if (topologyRejected(c, options.analysis)) {
+        return CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY;
+    }
+
+    try {
+        if (!monteCarloAnalysis(*c, options, c->monteCarloResult)) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        return CIRCUIT_SIM_SUCCESS;
+    }
+    catch (...) {
+        return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+    }
+}
+
+static const MonteCarloStatistics* findMonteCarloOutput(void* circuit, const char* outputNode) {
+    for (const auto& s : static_cast<Circuit*>(circuit)->monteCarloResult.outputs) {
+        if (s.output == outputNode) return &s;
+    }
+    return nullptr;
+}
+
+// Runs the circuit's .step sweep for comma-separated output nodes
+static int runParameterSweep(void* circuit, const char* outputNodes, ParameterSweepOptions& options) {
+    Circuit* c = static_cast<Circuit*>(circuit);
+    std::stringstream ss(outputNodes);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        if (!name.empty()) options.outputs.push_back(name);
+    }
+    if (topologyRejected(c, options.analysis)) {
+        return CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY;
+    }
+
+    try {
+        if (!parameterSweepAnalysis(*c, options, c->parameterSweepResult)) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        return CIRCUIT_SIM_SUCCESS;
+    }
+    catch (...) {
+        return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+    }
+}
+
 extern "C" {
     void* CreateCircuit() {
         try {
@@ -114,6 +239,48 @@ extern "C" {
         }
     }
 
+    // A positive zenerVoltage creates a zener diode, otherwise a normal diode.
+    int AddDiode(void* circuit, const char* name, const char* anode, const char* cathode, double forwardVoltage, double zenerVoltage) {
+        if (!circuit || !name || !anode || !cathode) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        
+        if (forwardVoltage < 0 || zenerVoltage < 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        
+        try {
+            Circuit* c = static_cast<Circuit*>(circuit);
+            Node* n1 = c->findOrCreateNode(anode);
+            Node* n2 = c->findOrCreateNode(cathode);
+            c->diodes.emplace_back(name, n1, n2, zenerVoltage > 0 ? ZENER : NORMAL, forwardVoltage, zenerVoltage);
+            return CIRCUIT_SIM_SUCCESS;
+        }
+        catch (...) {
+            return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+        }
+    }
+
+    int SetDiodeShockleyModel(void* circuit, const char* name, double saturationCurrent, double emissionCoefficient) {
+        if (!circuit || !name) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        
+        if (saturationCurrent <= 0 || emissionCoefficient <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        
+        Diode* d = static_cast<Circuit*>(circuit)->findDiode(name);
+        if (!d) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+        
+        d->saturationCurrent = saturationCurrent;
+        d->emissionCoefficient = emissionCoefficient;
+        d->setModel(MODEL_SHOCKLEY);
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
     int SetGroundNode(void* circuit, const char* nodeName) {
         if (!circuit || !nodeName) {
             return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
@@ -135,13 +302,16 @@ extern "C" {
             return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
         
-        try {
-            dcAnalysis(*static_cast<Circuit*>(circuit));
-            return CIRCUIT_SIM_SUCCESS;
-        }
-        catch (...) {
-            return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+        return runAnalysis(circuit, [&](Circuit& c) { dcAnalysis(c); });
+    }
+
+    // diodeSolver: 0 = state relaxation, 1 = LCP (Lemke)
+    int RunDCAnalysisWithDiodeSolver(void* circuit, int diodeSolver) {
+        if (!circuit || diodeSolver < 0 || diodeSolver > 1) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
+        
+        return runAnalysis(circuit, [&](Circuit& c) { dcAnalysis(c, diodeSolver == 1 ? DiodeSolverType::LCP : DiodeSolverType::RELAXATION); });
     }
 
     int RunTransientAnalysis(void* circuit, double stepTime, double stopTime) {
@@ -153,9 +323,38 @@ extern "C" {
             return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
         
+        return runAnalysis(circuit, [&](Circuit& c) { transientAnalysis(c, stepTime, stopTime); });
+    }
+
+    // maxDeviation (may be null) receives the largest node voltage difference
+    // from the monolithic transient when compareMonolithic is set, else -1;
+    // bypassedFraction (may be null) the share of device evaluations skipped
+    // by latent partitions
+    int RunWaveformRelaxationTransient(void* circuit, double stepTime, double stopTime, int gaussSeidel, int compareMonolithic, double* maxDeviation, double* bypassedFraction) {
+        if (!circuit) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        if (stepTime <= 0 || stopTime <= 0 || stepTime > stopTime) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        WaveformRelaxationOptions options;
+        options.t_step = stepTime;
+        options.t_stop = stopTime;
+        options.relaxation = gaussSeidel ? RelaxationType::GAUSS_SEIDEL : RelaxationType::JACOBI;
+        options.compareMonolithic = compareMonolithic != 0;
         try {
-            transientAnalysis(*static_cast<Circuit*>(circuit), stepTime, stopTime);
-            return CIRCUIT_SIM_SUCCESS;
+            WaveformRelaxationResult result;
+            Circuit* c = static_cast<Circuit*>(circuit);
+            bool converged = waveformRelaxationAnalysis(*c, options, result);
+            if (maxDeviation) *maxDeviation = result.maxDeviation;
+            if (bypassedFraction) {
+                long long total = result.deviceEvaluations + result.bypassedEvaluations;
+                *bypassedFraction = total > 0 ? (double)result.bypassedEvaluations / total : 0.0;
+            }
+            if (c->topology.rejected) return CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY;
+            return converged ? CIRCUIT_SIM_SUCCESS : CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
         }
         catch (...) {
             return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
@@ -174,15 +373,52 @@ extern "C" {
         // Use "LIN" as default sweep type if not provided
         std::string sweep = sweepType ? sweepType : "LIN";
         
-        try {
-            acSweepAnalysis(*static_cast<Circuit*>(circuit), sourceName, startFreq, stopFreq, numPoints, sweep);
-            return CIRCUIT_SIM_SUCCESS;
+        return runAnalysis(circuit, [&](Circuit& c) { acSweepAnalysis(c, sourceName, startFreq, stopFreq, numPoints, sweep); });
+    }
+    
+    // Same as RunACAnalysis, but points come from a reduced-order model that is
+    // built on first use and reused while the circuit is unchanged.
+    int RunReducedACAnalysis(void* circuit, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType) {
+        if (!circuit || !sourceName) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
-        catch (...) {
-            return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+
+        if (startFreq <= 0 || stopFreq <= 0 || startFreq > stopFreq || numPoints <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
+
+        std::string sweep = sweepType ? sweepType : "LIN";
+
+        return runAnalysis(circuit, [&](Circuit& c) { acSweepAnalysis(c, sourceName, startFreq, stopFreq, numPoints, sweep, ACSolverType::REDUCED_ORDER); });
     }
-    
+
+    int ExportReducedACModel(void* circuit, const char* path) {
+        if (!circuit || !path) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const ReducedACModel& model = static_cast<Circuit*>(circuit)->acReducedModel;
+        if (model.empty()) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+        return model.save(path) ? CIRCUIT_SIM_SUCCESS : CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+    }
+
+    // The imported model is used by the next reduced sweep only if it was built
+    // for the same circuit values and covers the requested frequency range.
+    int ImportReducedACModel(void* circuit, const char* path) {
+        if (!circuit || !path) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        ReducedACModel model;
+        if (!model.load(path)) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+        static_cast<Circuit*>(circuit)->acReducedModel = model;
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
     int RunPhaseAnalysis(void* circuit, const char* sourceName, double baseFreq, double startPhase, double stopPhase, int numPoints) {
         if (!circuit || !sourceName) {
             return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
@@ -192,13 +428,285 @@ extern "C" {
             return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
         
-        try {
-            phaseSweepAnalysis(*static_cast<Circuit*>(circuit), sourceName, baseFreq, startPhase, stopPhase, numPoints);
-            return CIRCUIT_SIM_SUCCESS;
+        return runAnalysis(circuit, [&](Circuit& c) { phaseSweepAnalysis(c, sourceName, baseFreq, startPhase, stopPhase, numPoints); });
+    }
+
+    // distribution: 0 = uniform in +-tolerance, 1 = gaussian with 3 sigma = tolerance
+    int SetComponentTolerance(void* circuit, const char* componentName, int distribution, double tolerance) {
+        if (!circuit || !componentName || tolerance < 0 || (distribution != 0 && distribution != 1)) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
-        catch (...) {
-            return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+
+        Circuit* c = static_cast<Circuit*>(circuit);
+        if (!c->findResistor(componentName) && !c->findCapacitor(componentName) && !c->findInductor(componentName)) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+
+        VariationDistribution dist = distribution == 1 ? VariationDistribution::GAUSSIAN : VariationDistribution::UNIFORM;
+        for (auto& v : c->componentVariations) {
+            if (v.component == componentName) {
+                v.distribution = dist;
+                v.tolerance = tolerance;
+                return CIRCUIT_SIM_SUCCESS;
+            }
+        }
+        c->componentVariations.push_back({componentName, dist, tolerance});
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    int ClearComponentTolerances(void* circuit) {
+        if (!circuit) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        static_cast<Circuit*>(circuit)->componentVariations.clear();
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    int RunMonteCarloDC(void* circuit, const char* outputNodes, int trials, unsigned long long seed) {
+        if (!circuit || !outputNodes || trials <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        MonteCarloOptions options;
+        options.analysis = AnalysisType::DC;
+        options.trials = trials;
+        options.seed = seed;
+        return runMonteCarlo(circuit, outputNodes, options);
+    }
+
+    int RunMonteCarloTransient(void* circuit, const char* outputNodes, int trials, unsigned long long seed, double stepTime, double stopTime) {
+        if (!circuit || !outputNodes || trials <= 0 || stepTime <= 0 || stopTime < stepTime) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        MonteCarloOptions options;
+        options.analysis = AnalysisType::TRANSIENT;
+        options.trials = trials;
+        options.seed = seed;
+        options.t_step = stepTime;
+        options.t_stop = stopTime;
+        return runMonteCarlo(circuit, outputNodes, options);
+    }
+
+    int RunMonteCarloAC(void* circuit, const char* outputNodes, int trials, unsigned long long seed, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType) {
+        if (!circuit || !outputNodes || !sourceName || trials <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        if (startFreq <= 0 || stopFreq <= 0 || startFreq > stopFreq || numPoints <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        MonteCarloOptions options;
+        options.analysis = AnalysisType::AC_SWEEP;
+        options.trials = trials;
+        options.seed = seed;
+        options.acSource = sourceName;
+        options.f_start = startFreq;
+        options.f_stop = stopFreq;
+        options.ac_points = numPoints;
+        options.sweep_type = sweepType ? sweepType : "Logarithmic";
+        return runMonteCarlo(circuit, outputNodes, options);
+    }
+
+    int GetMonteCarloAxis(void* circuit, double* axis, int maxCount) {
+        if (!circuit || !axis || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const auto& values = static_cast<Circuit*>(circuit)->monteCarloResult.axis;
+        int count = std::min(static_cast<int>(values.size()), maxCount);
+        for (int i = 0; i < count; ++i) axis[i] = values[i];
+        return count;
+    }
+
+    int GetMonteCarloStatistics(void* circuit, const char* outputNode, double* mean, double* stddev, double* minimum, double* maximum, int maxCount) {
+        if (!circuit || !outputNode || !mean || !stddev || !minimum || !maximum || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const MonteCarloStatistics* s = findMonteCarloOutput(circuit, outputNode);
+        if (!s) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+
+        int count = std::min(static_cast<int>(s->mean.size()), maxCount);
+        for (int i = 0; i < count; ++i) {
+            mean[i] = s->mean[i];
+            stddev[i] = s->stddev[i];
+            minimum[i] = s->minimum[i];
+            maximum[i] = s->maximum[i];
+        }
+        return count;
+    }
+
+    // range receives {low, high} of the histogram of the final axis point
+    int GetMonteCarloHistogram(void* circuit, const char* outputNode, double* range, int* counts, int maxBins) {
+        if (!circuit || !outputNode || !range || !counts || maxBins <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const MonteCarloStatistics* s = findMonteCarloOutput(circuit, outputNode);
+        if (!s) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+
+        range[0] = s->histogramMin;
+        range[1] = s->histogramMax;
+        int count = std::min(static_cast<int>(s->histogram.size()), maxBins);
+        for (int i = 0; i < count; ++i) counts[i] = s->histogram[i];
+        return count;
+    }
+
+    int AddStepParameter(void* circuit, const char* componentName, const double* values, int count) {
+        if (!circuit || !componentName || !values || count <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        Circuit* c = static_cast<Circuit*>(circuit);
+        if (!c->findComponentValue(componentName)) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+        c->stepParameters.push_back({componentName, std::vector<double>(values, values + count)});
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    int ClearStepParameters(void* circuit) {
+        if (!circuit) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        static_cast<Circuit*>(circuit)->stepParameters.clear();
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    int RunStepDC(void* circuit, const char* outputNodes) {
+        if (!circuit || !outputNodes) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        ParameterSweepOptions options;
+        options.analysis = AnalysisType::DC;
+        return runParameterSweep(circuit, outputNodes, options);
+    }
+
+    int RunStepTransient(void* circuit, const char* outputNodes, double stepTime, double stopTime) {
+        if (!circuit || !outputNodes || stepTime <= 0 || stopTime < stepTime) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        ParameterSweepOptions options;
+        options.analysis = AnalysisType::TRANSIENT;
+        options.t_step = stepTime;
+        options.t_stop = stopTime;
+        return runParameterSweep(circuit, outputNodes, options);
+    }
+
+    int RunStepAC(void* circuit, const char* outputNodes, const char* sourceName, double startFreq, double stopFreq, int numPoints, const char* sweepType) {
+        if (!circuit || !outputNodes || !sourceName) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        if (startFreq <= 0 || stopFreq <= 0 || startFreq > stopFreq || numPoints <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        ParameterSweepOptions options;
+        options.analysis = AnalysisType::AC_SWEEP;
+        options.acSource = sourceName;
+        options.f_start = startFreq;
+        options.f_stop = stopFreq;
+        options.ac_points = numPoints;
+        options.sweep_type = sweepType ? sweepType : "Logarithmic";
+        return runParameterSweep(circuit, outputNodes, options);
+    }
+
+    // shape receives the parameter value counts followed by the axis length;
+    // returns the number of dimensions
+    int GetStepShape(void* circuit, int* shape, int maxDims) {
+        if (!circuit || !shape || maxDims <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const auto& dims = static_cast<Circuit*>(circuit)->parameterSweepResult.shape;
+        int count = std::min(static_cast<int>(dims.size()), maxDims);
+        for (int i = 0; i < count; ++i) shape[i] = static_cast<int>(dims[i]);
+        return count;
+    }
+
+    int GetStepAxis(void* circuit, double* axis, int maxCount) {
+        if (!circuit || !axis || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const auto& values = static_cast<Circuit*>(circuit)->parameterSweepResult.axis;
+        int count = std::min(static_cast<int>(values.size()), maxCount);
+        std::memcpy(axis, values.data(), count * sizeof(double));
+        return count;
+    }
+
+    // Row-major in GetStepShape order; points that failed hold NaN
+    int GetStepResult(void* circuit, const char* outputNode, double* values, int maxCount) {
+        if (!circuit || !outputNode || !values || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const ParameterSweepResult& r = static_cast<Circuit*>(circuit)->parameterSweepResult;
+        for (size_t o = 0; o < r.outputs.size(); ++o) {
+            if (r.outputs[o] != outputNode) continue;
+            int count = std::min(static_cast<int>(r.values[o].size()), maxCount);
+            std::memcpy(values, r.values[o].data(), count * sizeof(double));
+            return count;
+        }
+        return CIRCUIT_SIM_ERROR_NOT_FOUND;
+    }
+
+    // 0 tears into one subdomain per worker thread, 1 disables tearing
+    int SetTearingPartitions(int partitions) {
+        if (partitions < 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+        setTearingPartitions(partitions);
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    // Describes the last torn solve; any pointer may be null
+    int GetTearingStatistics(long long* solves, int* subdomains, int* interfaceSize, int* unknowns, double* loadBalance) {
+        TearingStatistics stats = tearingStatistics();
+        if (solves) *solves = stats.solves;
+        if (subdomains) *subdomains = stats.subdomains;
+        if (interfaceSize) *interfaceSize = stats.interfaceSize;
+        if (unknowns) *unknowns = stats.unknowns;
+        if (loadBalance) *loadBalance = stats.loadBalance;
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    // Folds series chains out of every DC, transient and AC solve; off by default
+    int SetSeriesReduction(int enable) {
+        setSeriesReduction(enable != 0);
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    // 0 ties floating node groups to ground through gmin, 1 rejects them
+    int SetFloatingNodePolicy(int reject) {
+        setFloatingNodePolicy(reject ? FloatingNodePolicy::REJECT : FloatingNodePolicy::ADD_GMIN);
+        return CIRCUIT_SIM_SUCCESS;
+    }
+
+    // Issues found by the last topology check, one per line, naming the
+    // offending nodes and elements. Returns the length written including the
+    // terminator, or 0 if it does not fit.
+    int GetTopologyReport(void* circuit, char* buffer, int bufferSize) {
+        if (!circuit || !buffer || bufferSize <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
         }
+
+        std::string report = static_cast<Circuit*>(circuit)->topology.describe();
+        if (report.length() < static_cast<size_t>(bufferSize)) {
+            strcpy_s(buffer, bufferSize, report.c_str());
+            return static_cast<int>(report.length() + 1);
+        }
+        buffer[0] = '\0';
+        return 0;
     }
 
     int GetNodeVoltage(void* circuit, const char* nodeName, double* voltage) {
@@ -299,6 +807,116 @@ extern "C" {
         return count;
     }
 
+    int GetACFrequencies(void* circuit, double* frequencies, int maxCount) {
+        if (!circuit || !frequencies || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        const ACSweepResult& result = static_cast<Circuit*>(circuit)->acResult;
+        int count = std::min(static_cast<int>(result.pointCount()), maxCount);
+        if (count > 0) {
+            std::memcpy(frequencies, result.frequencies.data(), count * sizeof(double));
+        }
+        return count;
+    }
+
+    // Copies the complex column as interleaved (real, imag) pairs; realImag must
+    // hold 2 * maxCount doubles.
+    int GetACSolution(void* circuit, const char* name, double* realImag, int maxCount) {
+        if (!circuit || !name || !realImag || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        Circuit* c = static_cast<Circuit*>(circuit);
+        std::vector<std::complex<double>> scratch;
+        const std::complex<double>* column = findACColumn(c, name, scratch);
+        if (!column) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+
+        int count = std::min(static_cast<int>(c->acResult.pointCount()), maxCount);
+        if (count > 0) {
+            std::memcpy(realImag, column, count * sizeof(std::complex<double>));
+        }
+        return count;
+    }
+
+    // quantity: 0 = magnitude, 1 = phase (deg), 2 = magnitude (dB), 3 = group delay (s)
+    int GetACResponse(void* circuit, const char* name, int quantity, double* values, int maxCount) {
+        if (!circuit || !name || !values || maxCount <= 0 || quantity < AC_MAGNITUDE || quantity > AC_GROUP_DELAY) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        Circuit* c = static_cast<Circuit*>(circuit);
+        std::vector<std::complex<double>> scratch;
+        const std::complex<double>* column = findACColumn(c, name, scratch);
+        if (!column) {
+            return CIRCUIT_SIM_ERROR_NOT_FOUND;
+        }
+
+        std::vector<double> derived = c->acResult.derive(column, static_cast<ACQuantity>(quantity));
+        int count = std::min(static_cast<int>(derived.size()), maxCount);
+        if (count > 0) {
+            std::memcpy(values, derived.data(), count * sizeof(double));
+        }
+        return count;
+    }
+
+    // Sensitivities of one output to every R, C, L and source value, in the
+    // order of the comma-separated parameterNames (which may be null).
+    int GetDCSensitivities(void* circuit, const char* outputName, char* parameterNames, int bufferSize, double* sensitivities, int maxCount) {
+        if (!circuit || !outputName || !sensitivities || maxCount <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        std::vector<std::pair<std::string, double>> result;
+        Circuit* c = static_cast<Circuit*>(circuit);
+        c->topology = TopologyReport();
+        try {
+            if (!dcSensitivityAnalysis(*c, outputName, result)) {
+                return c->topology.rejected ? CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY : CIRCUIT_SIM_ERROR_NOT_FOUND;
+            }
+        }
+        catch (...) {
+            return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+        }
+
+        writeParameterNames(result, parameterNames, bufferSize);
+        int count = std::min(static_cast<int>(result.size()), maxCount);
+        for (int i = 0; i < count; ++i) {
+            sensitivities[i] = result[i].second;
+        }
+        return count;
+    }
+
+    // Complex sensitivities as interleaved (real, imag) pairs; realImag must
+    // hold 2 * maxCount doubles.
+    int GetACSensitivities(void* circuit, const char* outputName, double frequency, char* parameterNames, int bufferSize, double* realImag, int maxCount) {
+        if (!circuit || !outputName || !realImag || maxCount <= 0 || frequency <= 0) {
+            return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
+        }
+
+        std::vector<std::pair<std::string, std::complex<double>>> result;
+        Circuit* c = static_cast<Circuit*>(circuit);
+        c->topology = TopologyReport();
+        try {
+            if (!acSensitivityAnalysis(*c, outputName, frequency, result)) {
+                return c->topology.rejected ? CIRCUIT_SIM_ERROR_INVALID_TOPOLOGY : CIRCUIT_SIM_ERROR_NOT_FOUND;
+            }
+        }
+        catch (...) {
+            return CIRCUIT_SIM_ERROR_ANALYSIS_FAILED;
+        }
+
+        writeParameterNames(result, parameterNames, bufferSize);
+        int count = std::min(static_cast<int>(result.size()), maxCount);
+        for (int i = 0; i < count; ++i) {
+            realImag[2 * i] = result[i].second.real();
+            realImag[2 * i + 1] = result[i].second.imag();
+        }
+        return count;
+    }
+
     int GetComponentCurrentHistory(void* circuit, const char* componentName, double* timePoints, double* currents, int maxCount) {
         if (!circuit || !componentName || !timePoints || !currents || maxCount <= 0) {
             return CIRCUIT_SIM_ERROR_INVALID_ARGUMENT;
@@ -4,14 +4,23 @@
 
 using namespace std;
 
+namespace {
+    const double THERMAL_VOLTAGE = 0.025852; // kT/q at 300 K
+    const double GMIN = 1e-12;               // Keeps reverse biased junctions from floating
+}
+
 Diode::Diode(const string &name, Node *n1, Node *n2, DiodeType type, double vf, double vz)
         :
           diodeType(type),
+          diodeModel(MODEL_IDEAL),
           currentState(STATE_OFF),
           forwardVoltage(vf),
           zenerVoltage(vz),
           branchIndex(-1),
           current(0.0) {
+    this->name = name;
+    this->node1 = n1;
+    this->node2 = n2;
 }
 
 DiodeType Diode::getDiodeType() const {
@@ -42,11 +51,79 @@ int Diode::getBranchIndex() const {
     return branchIndex;
 }
 
+void Diode::setModel(DiodeModel model) {
+    diodeModel = model;
+    currentState = STATE_OFF;
+    branchIndex = -1;
+    linearize(junctionVoltage);
+}
+
+DiodeModel Diode::getModel() const {
+    return diodeModel;
+}
+
+double Diode::evaluateCurrent(double v, double* conductance) const {
+    const double vt = emissionCoefficient * THERMAL_VOLTAGE;
+    double e = exp(v / vt);
+    double i = saturationCurrent * (e - 1.0) + GMIN * v;
+    double g = saturationCurrent / vt * e + GMIN;
+
+    if (diodeType == ZENER && zenerVoltage > 0.0) {
+        double eb = breakdownCurrent * exp(-(v + zenerVoltage) / vt);
+        i -= eb;
+        g += eb / vt;
+    }
+
+    if (conductance) *conductance = g;
+    return i;
+}
+
+// pnjlim from SPICE3: steps past the critical voltage are compressed
+// logarithmically, so exp() stays finite and Newton cannot overshoot.
+static double pnjlim(double v_new, double v_old, double vt, double v_crit) {
+    if (v_new > v_crit && fabs(v_new - v_old) > 2.0 * vt) {
+        if (v_old > 0.0) {
+            double arg = 1.0 + (v_new - v_old) / vt;
+            v_new = (arg > 0.0) ? v_old + vt * log(arg) : v_crit;
+        } else {
+            v_new = vt * log(v_new / vt);
+        }
+    }
+    return v_new;
+}
+
+double Diode::limitJunctionVoltage(double v_new, double v_old) const {
+    const double vt = emissionCoefficient * THERMAL_VOLTAGE;
+    double v_crit = vt * log(vt / (sqrt(2.0) * saturationCurrent));
+    v_new = pnjlim(v_new, v_old, vt, v_crit);
+
+    // The breakdown knee is limited the same way, mirrored around -zenerVoltage.
+    if (diodeType == ZENER && zenerVoltage > 0.0) {
+        double v_crit_bd = vt * log(vt / (sqrt(2.0) * breakdownCurrent));
+        double u_new = -(v_new + zenerVoltage);
+        double u_old = -(v_old + zenerVoltage);
+        v_new = -pnjlim(u_new, u_old, vt, v_crit_bd) - zenerVoltage;
+    }
+    return v_new;
+}
+
+void Diode::linearize(double v) {
+    double g = 0.0;
+    double i = evaluateCurrent(v, &g);
+    junctionVoltage = v;
+    companionConductance = g;
+    companionCurrent = i - g * v;
+    current = i;
+}
+
 void Diode::setCurrent(double c) {
     current = c;
 }
 
 double Diode::getCurrent() {
+    if (diodeModel == MODEL_SHOCKLEY) {
+        return current;
+    }
     if (currentState == STATE_OFF) {
         return 0.0;
     }
@@ -0,0 +1,88 @@
+#include "LCPSolver.h"
+#include <cmath>
+
+using namespace std;
+
+bool solveLCPLemke(const vector<vector<double>>& M, const vector<double>& q, vector<double>& z) {
+    const double PIVOT_TOLERANCE = 1e-12;
+    int n = q.size();
+    z.assign(n, 0.0);
+
+    // Trivial solution z = 0 when q is already feasible
+    int most_negative = -1;
+    for (int i = 0; i < n; i++) {
+        if (q[i] < 0.0 && (most_negative == -1 || q[i] < q[most_negative])) {
+            most_negative = i;
+        }
+    }
+    if (most_negative == -1) return true;
+
+    // Tableau for  I*w - M*z - 1*z0 = q.  Columns: w[0..n), z[n..2n), z0 (2n), rhs (2n+1)
+    const int Z0 = 2 * n;
+    const int RHS = 2 * n + 1;
+    vector<vector<double>> T(n, vector<double>(2 * n + 2, 0.0));
+    vector<int> basis(n);
+    for (int i = 0; i < n; i++) {
+        T[i][i] = 1.0;
+        for (int j = 0; j < n; j++) {
+            T[i][n + j] = -M[i][j];
+        }
+        T[i][Z0] = -1.0;
+        T[i][RHS] = q[i];
+        basis[i] = i;
+    }
+
+    auto pivot = [&](int row, int col) {
+        double p = T[row][col];
+        for (double& v : T[row]) v /= p;
+        for (int i = 0; i < n; i++) {
+            if (i == row || T[i][col] == 0.0) continue;
+            double factor = T[i][col];
+            for (int j = 0; j <= RHS; j++) {
+                T[i][j] -= factor * T[row][j];
+            }
+        }
+        int leaving = basis[row];
+        basis[row] = col;
+        return leaving;
+    };
+
+    // z0 enters at the row of the most negative q, making every rhs non-negative
+    int leaving = pivot(most_negative, Z0);
+    const int MAX_PIVOTS = 50 * (n + 1);
+
+    for (int iter = 0; iter < MAX_PIVOTS; iter++) {
+        // The complement of the variable that just left enters the basis
+        int entering = (leaving < n) ? leaving + n : leaving - n;
+
+        // Minimum ratio test; ties are resolved in favour of z0 leaving
+        int row = -1;
+        double best_ratio = 0.0;
+        for (int i = 0; i < n; i++) {
+            if (T[i][entering] <= PIVOT_TOLERANCE) continue;
+            double ratio = T[i][RHS] / T[i][entering];
+            if (row == -1 || ratio < best_ratio - PIVOT_TOLERANCE ||
+                (fabs(ratio - best_ratio) <= PIVOT_TOLERANCE && basis[i] == Z0)) {
+                row = i;
+                best_ratio = ratio;
+            }
+        }
+        if (row == -1) {
+            z.clear();
+            return false; // Secondary ray
+        }
+
+        leaving = pivot(row, entering);
+        if (leaving == Z0) {
+            for (int i = 0; i < n; i++) {
+                if (basis[i] >= n && basis[i] < 2 * n) {
+                    z[basis[i] - n] = T[i][RHS];
+                }
+            }
+            return true;
+        }
+    }
+
+    z.clear();
+    return false;
+}
@@ -3,12 +3,392 @@
 #include <cmath>
 #include <algorithm>
 #include <complex>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <set>
+#include <limits>
 #include "LinearSolver.h"
+#include "ThreadPool.h"
+#include "UnionFind.h"
 
 using namespace std;
 
-vector<complex<double>> gaussianElimination(vector<vector<complex<double>>> A, vector<complex<double>> b) {
-    int n = A.size();
+namespace {
+
+// Largest system solved by a fixed-size kernel
+const int MAX_FIXED_SIZE = 16;
+
+// The elimination below on a stack-resident N x N copy. N is a compile-time
+// constant, so every loop has a fixed trip count the compiler can unroll, and
+// nothing is allocated besides the result. Rows with nothing to eliminate are
+// skipped and each pivot is inverted once.
+template <typename T, int N>
+vector<T> solveFixed(const vector<vector<T>>& A_in, const vector<T>& b_in) {
+    T A[N][N];
+    T b[N];
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) A[i][j] = A_in[i][j];
+        b[i] = b_in[i];
+    }
+
+    for (int i = 0; i < N; i++) {
+        int max_row = i;
+        for (int k = i + 1; k < N; k++) {
+            if (abs(A[k][i]) > abs(A[max_row][i])) {
+                max_row = k;
+            }
+        }
+        if (max_row != i) {
+            for (int j = 0; j < N; j++) swap(A[i][j], A[max_row][j]);
+            swap(b[i], b[max_row]);
+        }
+
+        const T inverse = T(1) / A[i][i];
+        for (int k = i + 1; k < N; k++) {
+            if (A[k][i] == T(0)) continue; // MNA rows are sparse
+            T factor = A[k][i] * inverse;
+            for (int j = i; j < N; j++) {
+                A[k][j] -= factor * A[i][j];
+            }
+            b[k] -= factor * b[i];
+        }
+    }
+
+    vector<T> x(N);
+    for (int i = N - 1; i >= 0; i--) {
+        T sum = b[i];
+        for (int j = i + 1; j < N; j++) {
+            sum -= A[i][j] * x[j];
+        }
+        x[i] = sum / A[i][i];
+    }
+    return x;
+}
+
+template <typename T>
+using FixedSolver = vector<T> (*)(const vector<vector<T>>&, const vector<T>&);
+
+// Kernel for each size 1..MAX_FIXED_SIZE, indexed by size
+template <typename T>
+const FixedSolver<T> FIXED_SOLVERS[MAX_FIXED_SIZE + 1] = {
+    nullptr,
+    solveFixed<T, 1>, solveFixed<T, 2>, solveFixed<T, 3>, solveFixed<T, 4>,
+    solveFixed<T, 5>, solveFixed<T, 6>, solveFixed<T, 7>, solveFixed<T, 8>,
+    solveFixed<T, 9>, solveFixed<T, 10>, solveFixed<T, 11>, solveFixed<T, 12>,
+    solveFixed<T, 13>, solveFixed<T, 14>, solveFixed<T, 15>, solveFixed<T, 16>,
+};
+
+// Off-diagonal structure of A + A'
+vector<vector<int>> symmetricAdjacency(const vector<vector<double>>& A) {
+    const int n = A.size();
+    vector<vector<int>> adjacency(n);
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (A[i][j] != 0.0 || A[j][i] != 0.0) {
+                adjacency[i].push_back(j);
+                adjacency[j].push_back(i);
+            }
+        }
+    }
+    return adjacency;
+}
+
+// Reverse Cuthill-McKee order of a system with its bandwidth in that order
+struct BandOrder {
+    vector<int> order;    // Unknown placed k-th
+    vector<int> position; // Place of each unknown
+    int kl = 0;
+    int ku = 0;
+
+    explicit BandOrder(const vector<vector<int>>& adjacency) : order(reverseCuthillMcKee(adjacency)), position(order.size()) {
+        for (size_t k = 0; k < order.size(); k++) position[order[k]] = k;
+        for (size_t i = 0; i < adjacency.size(); i++) {
+            for (int j : adjacency[i]) {
+                int d = position[j] - position[i];
+                kl = max(kl, -d);
+                ku = max(ku, d);
+            }
+        }
+    }
+
+    double cost() const { return (double)order.size() * kl * (kl + ku + 1); }
+};
+
+// Solves A x = b as a band matrix in reverse Cuthill-McKee order, if the band
+// makes that at least four times cheaper than dense elimination. Returns false
+// when it does not, or on a zero pivot.
+bool solveBanded(const vector<vector<double>>& A, const vector<double>& b, const vector<vector<int>>& adjacency,
+                 const BandOrder& bands, vector<double>& x) {
+    const int n = A.size();
+    double dense_cost = (double)n * n * n / 3.0;
+    if (4.0 * bands.cost() > dense_cost) return false;
+
+    const vector<int>& order = bands.order;
+    const vector<int>& position = bands.position;
+    BandLUFactorization f;
+    f.n = n;
+    f.kl = bands.kl;
+    f.ku = bands.ku;
+    f.band.assign((size_t)n * f.width(), 0.0);
+    for (int i = 0; i < n; i++) {
+        f.at(position[i], position[i]) = A[i][i];
+        for (int j : adjacency[i]) f.at(position[i], position[j]) = A[i][j];
+    }
+    if (!bandLUFactorize(f)) return false;
+
+    vector<double> pb(n);
+    for (int k = 0; k < n; k++) pb[k] = b[order[k]];
+    vector<double> px = bandLUSolve(f, pb);
+    x.resize(n);
+    for (int k = 0; k < n; k++) x[order[k]] = px[k];
+    return true;
+}
+
+mutex tearingMutex;
+int tearingPartitions = 0;
+TearingStatistics tearingStats;
+
+// Circuit tearing. The reverse Cuthill-McKee order is cut into k contiguous
+// subdomains; every unknown coupled to a later subdomain joins the interface,
+// so the remaining interiors are decoupled from each other. Each interior is
+// band-factored concurrently and condensed onto the interface unknowns it
+// touches; the interface then solves its Schur complement
+//     S = A_GG - sum_c A_Gc inv(A_cc) A_cG
+// densely, and the interiors recover their unknowns from it. Each interior pays
+// one band solve per interface unknown it touches, so tearing is used only when
+// the estimated parallel cost saves a quarter of the single-threaded one.
+bool solveTorn(const vector<vector<double>>& A, const vector<double>& b, const vector<vector<int>>& adjacency,
+               const BandOrder& bands, vector<double>& x) {
+    const int MIN_TEARING_SIZE = 200;
+    const int MIN_SUBDOMAIN_SIZE = 32;
+    const int n = A.size();
+
+    ThreadPool& pool = ThreadPool::shared();
+    int k;
+    {
+        lock_guard<mutex> lock(tearingMutex);
+        k = tearingPartitions;
+    }
+    if (k == 0) k = pool.size();
+    k = min(k, n / MIN_SUBDOMAIN_SIZE);
+    if (k < 2 || n < MIN_TEARING_SIZE) return false;
+
+    vector<int> part(n);
+    for (int p = 0; p < n; p++) part[bands.order[p]] = (int)((long long)p * k / n);
+
+    vector<int> interfaceIndex(n, -1);
+    vector<int> interfaceUnknowns;
+    for (int p = 0; p < n; p++) {
+        int i = bands.order[p];
+        bool coupled_later = any_of(adjacency[i].begin(), adjacency[i].end(), [&](int j) { return part[j] > part[i]; });
+        if (coupled_later) {
+            interfaceIndex[i] = interfaceUnknowns.size();
+            interfaceUnknowns.push_back(i);
+        }
+    }
+    const int s = interfaceUnknowns.size();
+    // Nothing left to condense
+    if (s == n) return false;
+
+    struct Subdomain {
+        vector<int> interior;    // In band order
+        vector<int> boundary;    // Interface positions coupled to the interior
+        BandLUFactorization f;
+        vector<double> y;        // inv(A_cc) b_c
+        vector<vector<double>> Y; // inv(A_cc) A_cG, one column per boundary unknown
+        vector<vector<double>> schur; // A_Gc inv(A_cc) A_cG over the boundary
+        vector<double> rhs;      // A_Gc inv(A_cc) b_c over the boundary
+    };
+    vector<Subdomain> subdomains(k);
+    vector<int> local(n, -1);
+    for (int p = 0; p < n; p++) {
+        int i = bands.order[p];
+        if (interfaceIndex[i] != -1) continue;
+        Subdomain& d = subdomains[part[i]];
+        local[i] = d.interior.size();
+        d.interior.push_back(i);
+    }
+
+    // Interior unknowns only couple to their own subdomain or to the interface
+    double serial_cost = min(bands.cost(), (double)n * n * n / 3.0);
+    double parallel_cost = 0.0;
+    size_t largest = 0;
+    vector<char> seen(s, 0);
+    for (Subdomain& d : subdomains) {
+        d.f.n = d.interior.size();
+        for (int i : d.interior) {
+            for (int j : adjacency[i]) {
+                if (interfaceIndex[j] != -1) {
+                    if (!seen[interfaceIndex[j]]) {
+                        seen[interfaceIndex[j]] = 1;
+                        d.boundary.push_back(interfaceIndex[j]);
+                    }
+                    continue;
+                }
+                int diff = local[j] - local[i];
+                d.f.kl = max(d.f.kl, -diff);
+                d.f.ku = max(d.f.ku, diff);
+            }
+        }
+        for (int g : d.boundary) seen[g] = 0;
+        sort(d.boundary.begin(), d.boundary.end());
+
+        double m = d.interior.size();
+        double q = d.boundary.size();
+        parallel_cost = max(parallel_cost, m * d.f.kl * (d.f.kl + d.f.ku + 1) + q * m * d.f.width());
+        largest = max(largest, d.interior.size());
+    }
+    parallel_cost += (double)s * s * s / 3.0;
+    if (parallel_cost > 0.75 * serial_cost) return false;
+
+    atomic<bool> singular(false);
+    pool.parallelForDynamic(k, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            Subdomain& d = subdomains[c];
+            const int m = d.interior.size();
+            const int q = d.boundary.size();
+            d.f.band.assign((size_t)m * d.f.width(), 0.0);
+            vector<double> b_c(m);
+            for (int li = 0; li < m; li++) {
+                int i = d.interior[li];
+                d.f.at(li, li) = A[i][i];
+                for (int j : adjacency[i]) {
+                    if (local[j] != -1 && interfaceIndex[j] == -1) d.f.at(li, local[j]) = A[i][j];
+                }
+                b_c[li] = b[i];
+            }
+            if (!bandLUFactorize(d.f)) {
+                singular = true;
+                return;
+            }
+            d.y = bandLUSolve(d.f, b_c);
+
+            d.Y.resize(q);
+            for (int t = 0; t < q; t++) {
+                int g = interfaceUnknowns[d.boundary[t]];
+                vector<double> column(m, 0.0);
+                for (int j : adjacency[g]) {
+                    if (interfaceIndex[j] == -1 && part[j] == (int)c) column[local[j]] = A[j][g];
+                }
+                d.Y[t] = bandLUSolve(d.f, column);
+            }
+
+            d.schur.assign(q, vector<double>(q, 0.0));
+            d.rhs.assign(q, 0.0);
+            for (int r = 0; r < q; r++) {
+                int g = interfaceUnknowns[d.boundary[r]];
+                for (int j : adjacency[g]) {
+                    if (interfaceIndex[j] != -1 || part[j] != (int)c) continue;
+                    double a = A[g][j];
+                    if (a == 0.0) continue;
+                    d.rhs[r] += a * d.y[local[j]];
+                    for (int t = 0; t < q; t++) d.schur[r][t] += a * d.Y[t][local[j]];
+                }
+            }
+        }
+    });
+    if (singular) return false;
+
+    // Interface system, reduced in subdomain order so the result is deterministic
+    vector<vector<double>> S(s, vector<double>(s));
+    vector<double> g(s);
+    for (int r = 0; r < s; r++) {
+        for (int t = 0; t < s; t++) S[r][t] = A[interfaceUnknowns[r]][interfaceUnknowns[t]];
+        g[r] = b[interfaceUnknowns[r]];
+    }
+    for (const Subdomain& d : subdomains) {
+        for (size_t r = 0; r < d.boundary.size(); r++) {
+            g[d.boundary[r]] -= d.rhs[r];
+            for (size_t t = 0; t < d.boundary.size(); t++) S[d.boundary[r]][d.boundary[t]] -= d.schur[r][t];
+        }
+    }
+    // A singular interface falls back to the band path like a singular interior
+    vector<double> x_interface;
+    if (s > 0) {
+        LUFactorization F = luFactorize(move(S));
+        for (int r = 0; r < s; r++) {
+            if (F.LU[r][r] == 0.0 || !isfinite(F.LU[r][r])) return false;
+        }
+        x_interface = luSolve(F, g);
+    }
+
+    x.assign(n, 0.0);
+    for (int r = 0; r < s; r++) x[interfaceUnknowns[r]] = x_interface[r];
+    pool.parallelForDynamic(k, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            const Subdomain& d = subdomains[c];
+            for (size_t li = 0; li < d.interior.size(); li++) {
+                double value = d.y[li];
+                for (size_t t = 0; t < d.boundary.size(); t++) value -= d.Y[t][li] * x_interface[d.boundary[t]];
+                x[d.interior[li]] = value;
+            }
+        }
+    });
+
+    lock_guard<mutex> lock(tearingMutex);
+    tearingStats.solves++;
+    tearingStats.subdomains = k;
+    tearingStats.interfaceSize = s;
+    tearingStats.unknowns = n;
+    tearingStats.loadBalance = largest / ((double)(n - s) / k);
+    return true;
+}
+
+// Solves A x = b one connected block at a time when the unknowns fall into
+// independent islands (subcircuits that share only ground). Blocks are solved
+// concurrently, each through gaussianElimination, so every block still gets
+// the fixed-size, banded or dense path that suits it. Returns false for a
+// single island.
+bool solveIslands(const vector<vector<double>>& A, const vector<double>& b, const vector<vector<int>>& adjacency, vector<double>& x) {
+    const int n = A.size();
+    UnionFind sets(n);
+    for (int i = 0; i < n; i++) {
+        for (int j : adjacency[i]) sets.unite(i, j);
+    }
+
+    vector<int> block_of(n, -1);
+    vector<vector<int>> blocks;
+    for (int i = 0; i < n; i++) {
+        int root = sets.find(i);
+        if (block_of[root] == -1) {
+            block_of[root] = blocks.size();
+            blocks.emplace_back();
+        }
+        blocks[block_of[root]].push_back(i);
+    }
+    if (blocks.size() < 2) return false;
+
+    // Largest blocks first, so one big island does not start last
+    sort(blocks.begin(), blocks.end(), [](const vector<int>& a, const vector<int>& b) { return a.size() > b.size(); });
+
+    x.assign(n, 0.0);
+    ThreadPool::shared().parallelForDynamic(blocks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            const vector<int>& unknowns = blocks[k];
+            const int m = unknowns.size();
+            vector<vector<double>> sub(m, vector<double>(m));
+            vector<double> rhs(m);
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < m; j++) sub[i][j] = A[unknowns[i]][unknowns[j]];
+                rhs[i] = b[unknowns[i]];
+            }
+            vector<double> sub_x = gaussianElimination(sub, rhs);
+            for (int i = 0; i < m; i++) x[unknowns[i]] = sub_x[i];
+        }
+    });
+    return true;
+}
+
+} // namespace
+
+vector<complex<double>> gaussianElimination(const vector<vector<complex<double>>>& A_in, const vector<complex<double>>& b_in) {
+    int n = A_in.size();
+    if (n >= 1 && n <= MAX_FIXED_SIZE) {
+        return FIXED_SOLVERS<complex<double>>[n](A_in, b_in);
+    }
+    vector<vector<complex<double>>> A = A_in;
+    vector<complex<double>> b = b_in;
 
     for (int i = 0; i < n; i++) {
         // Find pivot
@@ -44,8 +424,22 @@ vector<complex<double>> gaussianElimination(vector<vector<complex<double>>> A, v
 }
 
 // Add a version for real numbers
-vector<double> gaussianElimination(vector<vector<double>> A, vector<double> b) {
-    int n = A.size();
+vector<double> gaussianElimination(const vector<vector<double>>& A_in, const vector<double>& b_in) {
+    int n = A_in.size();
+    if (n >= 1 && n <= MAX_FIXED_SIZE) {
+        return FIXED_SOLVERS<double>[n](A_in, b_in);
+    }
+    if (n > MAX_FIXED_SIZE) {
+        vector<vector<int>> adjacency = symmetricAdjacency(A_in);
+        vector<double> x;
+        if (solveIslands(A_in, b_in, adjacency, x)) return x;
+        BandOrder bands(adjacency);
+        if (solveTorn(A_in, b_in, adjacency, bands, x) || solveBanded(A_in, b_in, adjacency, bands, x)) {
+            return x;
+        }
+    }
+    vector<vector<double>> A = A_in;
+    vector<double> b = b_in;
 
     for (int i = 0; i < n; i++) {
         // Find pivot
@@ -80,6 +474,413 @@ vector<double> gaussianElimination(vector<vector<double>> A, vector<double> b) {
     return x;
 }
 
+LUFactorization luFactorize(vector<vector<double>> A) {
+    int n = A.size();
+    LUFactorization f;
+    f.perm.resize(n);
+    for (int i = 0; i < n; i++) f.perm[i] = i;
+
+    for (int i = 0; i < n; i++) {
+        // Find pivot
+        int max_row = i;
+        for (int k = i + 1; k < n; k++) {
+            if (abs(A[k][i]) > abs(A[max_row][i])) {
+                max_row = k;
+            }
+        }
+        swap(A[i], A[max_row]);
+        swap(f.perm[i], f.perm[max_row]);
+
+        // Store multipliers below the pivot in place of the eliminated zeros
+        for (int k = i + 1; k < n; k++) {
+            double factor = A[k][i] / A[i][i];
+            A[k][i] = factor;
+            for (int j = i + 1; j < n; j++) {
+                A[k][j] -= factor * A[i][j];
+            }
+        }
+    }
+    f.LU = move(A);
+    return f;
+}
+
+vector<double> luSolve(const LUFactorization& f, const vector<double>& b) {
+    int n = f.LU.size();
+    vector<double> x(n);
+
+    // Forward substitution with the unit lower triangle
+    for (int i = 0; i < n; i++) {
+        x[i] = b[f.perm[i]];
+        for (int j = 0; j < i; j++) {
+            x[i] -= f.LU[i][j] * x[j];
+        }
+    }
+
+    // Back substitution
+    for (int i = n - 1; i >= 0; i--) {
+        for (int j = i + 1; j < n; j++) {
+            x[i] -= f.LU[i][j] * x[j];
+        }
+        x[i] /= f.LU[i][i];
+    }
+    return x;
+}
+
+vector<double> luSolveTransposed(const LUFactorization& f, const vector<double>& b) {
+    // PA = LU, so A' = U' L' P: solve U' z = b, then L' w = z, then x = P' w
+    int n = f.LU.size();
+    vector<double> z(b);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < i; j++) {
+            z[i] -= f.LU[j][i] * z[j];
+        }
+        z[i] /= f.LU[i][i];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        for (int k = i + 1; k < n; k++) {
+            z[i] -= f.LU[k][i] * z[k];
+        }
+    }
+
+    vector<double> x(n);
+    for (int i = 0; i < n; i++) x[f.perm[i]] = z[i];
+    return x;
+}
+
+vector<int> reverseCuthillMcKee(const vector<vector<int>>& adjacency) {
+    const int n = adjacency.size();
+    vector<int> order;
+    order.reserve(n);
+    vector<char> placed(n, 0);
+    auto degree = [&](int v) { return (int)adjacency[v].size(); };
+
+    // Breadth-first levels from start; returns the last vertex reached with the
+    // lowest degree and the number of levels
+    vector<int> level(n, -1);
+    auto farthest = [&](int start, int& depth) {
+        vector<int> visited{start};
+        level[start] = 0;
+        for (size_t head = 0; head < visited.size(); ++head) {
+            for (int w : adjacency[visited[head]]) {
+                if (level[w] == -1) {
+                    level[w] = level[visited[head]] + 1;
+                    visited.push_back(w);
+                }
+            }
+        }
+        depth = level[visited.back()];
+        int best = visited.back();
+        for (int v : visited) {
+            if (level[v] == depth && degree(v) < degree(best)) best = v;
+            level[v] = -1;
+        }
+        return best;
+    };
+
+    for (int seed = 0; seed < n; ++seed) {
+        if (placed[seed]) continue;
+
+        // Pseudo-peripheral start: walk to the far end until the depth stops growing
+        int start = seed;
+        int depth = 0;
+        int candidate = farthest(start, depth);
+        for (int pass = 0; pass < 4; ++pass) {
+            int next_depth = 0;
+            int next = farthest(candidate, next_depth);
+            if (next_depth <= depth) break;
+            start = candidate;
+            candidate = next;
+            depth = next_depth;
+        }
+
+        // Cuthill-McKee: breadth first, unplaced neighbours by increasing degree
+        size_t head = order.size();
+        order.push_back(start);
+        placed[start] = 1;
+        for (; head < order.size(); ++head) {
+            vector<int> next;
+            for (int w : adjacency[order[head]]) {
+                if (!placed[w]) {
+                    placed[w] = 1;
+                    next.push_back(w);
+                }
+            }
+            sort(next.begin(), next.end(), [&](int a, int b) { return degree(a) < degree(b); });
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+
+    reverse(order.begin(), order.end());
+    return order;
+}
+
+bool bandLUFactorize(BandLUFactorization& f) {
+    const int n = f.n;
+    f.pivots.resize(n);
+    for (int k = 0; k < n; ++k) {
+        const int last_row = min(n - 1, k + f.kl);
+        const int last_col = min(n - 1, k + f.kl + f.ku);
+
+        int p = k;
+        for (int r = k + 1; r <= last_row; ++r) {
+            if (abs(f.at(r, k)) > abs(f.at(p, k))) p = r;
+        }
+        f.pivots[k] = p;
+        if (f.at(p, k) == 0.0) return false;
+        // Columns left of k hold multipliers of earlier steps and stay in place;
+        // bandLUSolve applies each swap at its own step
+        if (p != k) {
+            for (int j = k; j <= last_col; ++j) swap(f.at(k, j), f.at(p, j));
+        }
+
+        const double inverse = 1.0 / f.at(k, k);
+        for (int r = k + 1; r <= last_row; ++r) {
+            double& entry = f.at(r, k);
+            if (entry == 0.0) continue;
+            entry *= inverse;
+            for (int j = k + 1; j <= last_col; ++j) {
+                f.at(r, j) -= entry * f.at(k, j);
+            }
+        }
+    }
+    return true;
+}
+
+vector<double> bandLUSolve(const BandLUFactorization& f, const vector<double>& b) {
+    const int n = f.n;
+    vector<double> x(b);
+    for (int k = 0; k < n; ++k) {
+        swap(x[k], x[f.pivots[k]]);
+        const int last_row = min(n - 1, k + f.kl);
+        for (int r = k + 1; r <= last_row; ++r) {
+            x[r] -= f.at(r, k) * x[k];
+        }
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        const int last_col = min(n - 1, i + f.kl + f.ku);
+        double sum = x[i];
+        for (int j = i + 1; j <= last_col; ++j) {
+            sum -= f.at(i, j) * x[j];
+        }
+        x[i] = sum / f.at(i, i);
+    }
+    return x;
+}
+
+void setTearingPartitions(int partitions) {
+    lock_guard<mutex> lock(tearingMutex);
+    tearingPartitions = max(0, partitions);
+}
+
+TearingStatistics tearingStatistics() {
+    lock_guard<mutex> lock(tearingMutex);
+    return tearingStats;
+}
+
+SparseLUPattern analyzeSparseLU(int n, const vector<pair<int, int>>& nonzeros, const vector<complex<double>>& sample) {
+    // A pivot must be at least this fraction of the largest entry in its column
+    const double PIVOT_THRESHOLD = 0.1;
+    // Columns with the fewest entries searched for a pivot at each step
+    const int SEARCH_COLUMNS = 4;
+
+    SparseLUPattern pattern;
+    pattern.n = n;
+    pattern.nonzeros = nonzeros;
+
+    // Active submatrix, by rows with values and by columns with structure only
+    vector<map<int, complex<double>>> rows(n);
+    vector<set<int>> columns(n);
+    for (size_t e = 0; e < nonzeros.size(); ++e) {
+        rows[nonzeros[e].first][nonzeros[e].second] += sample[e];
+        columns[nonzeros[e].second].insert(nonzeros[e].first);
+    }
+    set<pair<size_t, int>> byCount; // (entries, column) of the active columns
+    for (int c = 0; c < n; ++c) byCount.insert({columns[c].size(), c});
+    vector<char> rowDone(n, 0);
+
+    vector<vector<int>> upper(n); // Original columns of U row k beside the pivot
+    vector<vector<int>> lower(n); // Original rows of L column k
+    for (int k = 0; k < n; ++k) {
+        int p = -1, q = -1;
+        double bestCost = numeric_limits<double>::infinity(), bestMagnitude = 0.0;
+        int searched = 0;
+        for (auto it = byCount.begin(); it != byCount.end() && searched < SEARCH_COLUMNS; ++it, ++searched) {
+            const int c = it->second;
+            double columnMax = 0.0;
+            for (int r : columns[c]) columnMax = max(columnMax, abs(rows[r][c]));
+            for (int r : columns[c]) {
+                double magnitude = abs(rows[r][c]);
+                if (magnitude < PIVOT_THRESHOLD * columnMax) continue;
+                double cost = (rows[r].size() - 1.0) * (columns[c].size() - 1.0);
+                if (cost < bestCost || (cost == bestCost && magnitude > bestMagnitude)) {
+                    p = r;
+                    q = c;
+                    bestCost = cost;
+                    bestMagnitude = magnitude;
+                }
+            }
+        }
+        if (p == -1) {
+            // Structurally empty column: pair it with any row left, as a zero pivot
+            q = byCount.begin()->second;
+            p = find(rowDone.begin(), rowDone.end(), 0) - rowDone.begin();
+            rows[p][q];
+            byCount.erase({columns[q].size(), q});
+            columns[q].insert(p);
+            byCount.insert({columns[q].size(), q});
+        }
+        pattern.rowPerm.push_back(p);
+        pattern.colPerm.push_back(q);
+        rowDone[p] = 1;
+
+        // Detach the pivot row, then eliminate the pivot column from the rows below
+        for (const auto& entry : rows[p]) {
+            byCount.erase({columns[entry.first].size(), entry.first});
+            columns[entry.first].erase(p);
+        }
+        const complex<double> pivot = rows[p][q];
+        for (int r : columns[q]) {
+            complex<double> factor = pivot == 0.0 ? complex<double>(0.0) : rows[r][q] / pivot;
+            rows[r].erase(q);
+            for (const auto& [c, value] : rows[p]) {
+                if (c == q) continue;
+                auto [it, inserted] = rows[r].try_emplace(c, 0.0);
+                it->second -= factor * value;
+                if (inserted) columns[c].insert(r);
+            }
+            lower[k].push_back(r);
+        }
+        columns[q].clear();
+        for (const auto& entry : rows[p]) {
+            if (entry.first == q) continue;
+            upper[k].push_back(entry.first);
+            byCount.insert({columns[entry.first].size(), entry.first});
+        }
+        rows[p].clear();
+    }
+
+    // Factor rows in pivot order, L and U side by side
+    vector<int> rowPosition(n), colPosition(n);
+    for (int k = 0; k < n; ++k) {
+        rowPosition[pattern.rowPerm[k]] = k;
+        colPosition[pattern.colPerm[k]] = k;
+    }
+    vector<vector<int>> factorRows(n);
+    for (int k = 0; k < n; ++k) {
+        for (int r : lower[k]) factorRows[rowPosition[r]].push_back(k);
+        factorRows[k].push_back(k);
+        for (int c : upper[k]) factorRows[k].push_back(colPosition[c]);
+    }
+    pattern.start.assign(n + 1, 0);
+    pattern.diagonal.assign(n, 0);
+    for (int k = 0; k < n; ++k) {
+        sort(factorRows[k].begin(), factorRows[k].end());
+        pattern.start[k] = pattern.columns.size();
+        pattern.diagonal[k] = pattern.start[k] + (lower_bound(factorRows[k].begin(), factorRows[k].end(), k) - factorRows[k].begin());
+        pattern.columns.insert(pattern.columns.end(), factorRows[k].begin(), factorRows[k].end());
+    }
+    pattern.start[n] = pattern.columns.size();
+    for (int k = 0; k < n; ++k) {
+        for (int idx = pattern.start[k]; idx < pattern.diagonal[k]; ++idx) {
+            int j = pattern.columns[idx];
+            pattern.flops += pattern.start[j + 1] - pattern.diagonal[j];
+        }
+    }
+
+    pattern.slot.resize(nonzeros.size());
+    for (size_t e = 0; e < nonzeros.size(); ++e) {
+        int k = rowPosition[nonzeros[e].first];
+        auto first = pattern.columns.begin() + pattern.start[k];
+        auto last = pattern.columns.begin() + pattern.start[k + 1];
+        pattern.slot[e] = lower_bound(first, last, colPosition[nonzeros[e].second]) - pattern.columns.begin();
+    }
+    return pattern;
+}
+
+void SparseLUPattern::load(const vector<complex<double>>& entries, vector<complex<double>>& lu) const {
+    lu.assign(columns.size(), 0.0);
+    for (size_t e = 0; e < slot.size(); ++e) lu[slot[e]] = entries[e];
+}
+
+void SparseLUPattern::load(const vector<vector<complex<double>>>& A, vector<complex<double>>& lu) const {
+    lu.assign(columns.size(), 0.0);
+    for (size_t e = 0; e < slot.size(); ++e) lu[slot[e]] = A[nonzeros[e].first][nonzeros[e].second];
+}
+
+bool sparseLUFactor(const SparseLUPattern& pattern, vector<complex<double>>& lu) {
+    // Threshold pivoting keeps multipliers below 1 / PIVOT_THRESHOLD at the sample
+    // values; a fixed order that produces much larger ones is no longer stable
+    const double MAX_MULTIPLIER = 1e3;
+    const int n = pattern.n;
+    const vector<int>& cols = pattern.columns;
+
+    // Row by row: row k is reduced by the U rows of its L columns, in order
+    vector<complex<double>> work(n, 0.0);
+    for (int k = 0; k < n; ++k) {
+        for (int idx = pattern.start[k]; idx < pattern.start[k + 1]; ++idx) work[cols[idx]] = lu[idx];
+        for (int idx = pattern.start[k]; idx < pattern.diagonal[k]; ++idx) {
+            const int j = cols[idx];
+            complex<double> factor = work[j] / lu[pattern.diagonal[j]];
+            work[j] = factor;
+            if (factor == 0.0) continue;
+            if (abs(factor) > MAX_MULTIPLIER) return false;
+            for (int u = pattern.diagonal[j] + 1; u < pattern.start[j + 1]; ++u) {
+                work[cols[u]] -= factor * lu[u];
+            }
+        }
+        for (int idx = pattern.start[k]; idx < pattern.start[k + 1]; ++idx) {
+            lu[idx] = work[cols[idx]];
+            work[cols[idx]] = 0.0;
+        }
+        if (lu[pattern.diagonal[k]] == 0.0) return false;
+    }
+    return true;
+}
+
+void sparseLUSolveFactored(const SparseLUPattern& pattern, const vector<complex<double>>& lu, const vector<complex<double>>& b, vector<complex<double>>& x) {
+    // P A Q = L U
+    const int n = pattern.n;
+    const vector<int>& cols = pattern.columns;
+    vector<complex<double>> y(n);
+    for (int k = 0; k < n; ++k) y[k] = b[pattern.rowPerm[k]];
+    for (int k = 0; k < n; ++k) {
+        for (int idx = pattern.start[k]; idx < pattern.diagonal[k]; ++idx) y[k] -= lu[idx] * y[cols[idx]];
+    }
+    for (int k = n - 1; k >= 0; --k) {
+        for (int idx = pattern.diagonal[k] + 1; idx < pattern.start[k + 1]; ++idx) y[k] -= lu[idx] * y[cols[idx]];
+        y[k] /= lu[pattern.diagonal[k]];
+    }
+    x.assign(n, 0.0);
+    for (int k = 0; k < n; ++k) x[pattern.colPerm[k]] = y[k];
+}
+
+bool sparseLUSolve(const SparseLUPattern& pattern, vector<complex<double>>& lu, const vector<complex<double>>& b, vector<complex<double>>& x) {
+    if (!sparseLUFactor(pattern, lu)) return false;
+    sparseLUSolveFactored(pattern, lu, b, x);
+    return true;
+}
+
+void sparseLUSolveTransposed(const SparseLUPattern& pattern, const vector<complex<double>>& lu, const vector<complex<double>>& b, vector<complex<double>>& x) {
+    // A' = Q U' L' P
+    const int n = pattern.n;
+    const vector<int>& cols = pattern.columns;
+    vector<complex<double>> z(n);
+    for (int k = 0; k < n; ++k) z[k] = b[pattern.colPerm[k]];
+
+    // U' w = z, one column of U' (row of U) at a time
+    for (int k = 0; k < n; ++k) {
+        z[k] /= lu[pattern.diagonal[k]];
+        for (int idx = pattern.diagonal[k] + 1; idx < pattern.start[k + 1]; ++idx) z[cols[idx]] -= lu[idx] * z[k];
+    }
+    // L' v = w
+    for (int k = n - 1; k >= 0; --k) {
+        for (int idx = pattern.start[k]; idx < pattern.diagonal[k]; ++idx) z[cols[idx]] -= lu[idx] * z[k];
+    }
+
+    x.assign(n, 0.0);
+    for (int k = 0; k < n; ++k) x[pattern.rowPerm[k]] = z[k];
+}
+
 // Other functions (display_vec2D, display_vec, test_solver) remain the same...
 void test_solver() {
     vector<vector<double>> a = {{1, 6, 3, 6},
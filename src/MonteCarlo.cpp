@@ -0,0 +1,210 @@
+#include "Analysis.h"
+#include "ThreadPool.h"
+#include "BatchSimulator.h"
+#include <iostream>
+#include <random>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Welford running mean/variance with min and max; blocks merge with Chan's formula
+struct RunningStatistics {
+    long long count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double minimum = numeric_limits<double>::infinity();
+    double maximum = -numeric_limits<double>::infinity();
+
+    void add(double x) {
+        count++;
+        double delta = x - mean;
+        mean += delta / count;
+        m2 += delta * (x - mean);
+        minimum = min(minimum, x);
+        maximum = max(maximum, x);
+    }
+
+    void merge(const RunningStatistics& other) {
+        if (other.count == 0) return;
+        long long total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * (double)count * other.count / total;
+        count = total;
+        minimum = min(minimum, other.minimum);
+        maximum = max(maximum, other.maximum);
+    }
+};
+
+// SplitMix64: decorrelates consecutive trial indices into independent seeds
+uint64_t splitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+bool monteCarloAnalysis(Circuit& circuit, const MonteCarloOptions& options, MonteCarloResult& result) {
+    analysisOutput() << "// Performing Monte Carlo Analysis (" << options.trials << " trials)..." << endl;
+    result = MonteCarloResult();
+    if (options.trials <= 0) {
+        analysisErrors() << "Error: Monte Carlo needs at least one trial." << endl;
+        return false;
+    }
+    if (!options.validate(circuit, options.outputs)) return false;
+
+    // Trials start from a copy without stored results
+    Circuit nominal(circuit);
+    nominal.clearStoredResults();
+
+    // Resolve every variation to the value it scales
+    struct ResolvedVariation {
+        int kind; // 0 resistor, 1 capacitor, 2 inductor
+        size_t index;
+        const ComponentVariation* spec;
+    };
+    vector<ResolvedVariation> variations;
+    for (const auto& v : circuit.componentVariations) {
+        ResolvedVariation resolved{-1, 0, &v};
+        for (size_t i = 0; i < nominal.resistors.size(); ++i) {
+            if (nominal.resistors[i].name == v.component) resolved = {0, i, &v};
+        }
+        for (size_t i = 0; i < nominal.capacitors.size(); ++i) {
+            if (nominal.capacitors[i].name == v.component) resolved = {1, i, &v};
+        }
+        for (size_t i = 0; i < nominal.inductors.size(); ++i) {
+            if (nominal.inductors[i].name == v.component) resolved = {2, i, &v};
+        }
+        if (resolved.kind == -1) {
+            analysisErrors() << "Error: Monte Carlo variation on unknown component '" << v.component << "'." << endl;
+            return false;
+        }
+        variations.push_back(resolved);
+    }
+
+    // Common axis every trial is sampled onto
+    result.axis = options.axis();
+
+    const size_t num_outputs = options.outputs.size();
+    const size_t num_points = result.axis.size();
+    const size_t GRAIN = BATCH_LANES; // Trials per block; fixes the merge order independently of threads
+    const size_t blocks = (options.trials + GRAIN - 1) / GRAIN;
+
+    vector<vector<RunningStatistics>> blockStats(blocks);
+
+    // Linear circuits solve each block of GRAIN trials as one lane batch
+    const bool batched = options.analysis != AnalysisType::AC_SWEEP && isBatchable(nominal);
+    vector<string> variedNames;
+    vector<double> nominalValues;
+    for (const auto& v : variations) {
+        variedNames.push_back(v.spec->component);
+        if (v.kind == 0) nominalValues.push_back(nominal.resistors[v.index].resistance);
+        else if (v.kind == 1) nominalValues.push_back(nominal.capacitors[v.index].capacitance);
+        else nominalValues.push_back(nominal.inductors[v.index].inductance);
+    }
+    vector<double> finalValues(options.trials * num_outputs, numeric_limits<double>::quiet_NaN());
+    vector<char> failed(options.trials, 0);
+
+    ThreadPool::shared().parallelForDynamic(options.trials, GRAIN, [&](size_t begin, size_t end) {
+        // Trials run quietly on every pool thread they land on
+        bool wasQuiet = setThreadQuiet(true);
+        vector<RunningStatistics> stats(num_outputs * num_points);
+        const size_t count = end - begin;
+
+        // Each trial owns its RNG stream, so results do not depend on scheduling
+        vector<vector<double>> factors(count);
+        for (size_t t = 0; t < count; ++t) {
+            mt19937_64 rng(splitMix64(options.seed ^ splitMix64(begin + t)));
+            for (const auto& v : variations) {
+                double factor;
+                if (v.spec->distribution == VariationDistribution::GAUSSIAN) {
+                    factor = 1.0 + normal_distribution<double>(0.0, v.spec->tolerance / 3.0)(rng);
+                } else {
+                    factor = 1.0 + uniform_real_distribution<double>(-v.spec->tolerance, v.spec->tolerance)(rng);
+                }
+                factors[t].push_back(factor);
+            }
+        }
+
+        vector<vector<double>> trialSamples;
+        vector<char> trialOk;
+        vector<vector<double>> laneValues(count);
+        for (size_t t = 0; t < count && batched; ++t) {
+            for (size_t k = 0; k < variations.size(); ++k) laneValues[t].push_back(nominalValues[k] * factors[t][k]);
+        }
+        if (!batched || !batchedAnalysis(nominal, options, variedNames, laneValues, options.outputs, trialSamples, trialOk)) {
+            trialSamples.assign(count, vector<double>(num_outputs * num_points));
+            trialOk.assign(count, 0);
+            for (size_t t = 0; t < count; ++t) {
+                Circuit c(nominal);
+                for (size_t k = 0; k < variations.size(); ++k) {
+                    const auto& v = variations[k];
+                    if (v.kind == 0) c.resistors[v.index].resistance *= factors[t][k];
+                    else if (v.kind == 1) c.capacitors[v.index].capacitance *= factors[t][k];
+                    else c.inductors[v.index].inductance *= factors[t][k];
+                }
+                options.run(c);
+                trialOk[t] = options.sample(c, options.outputs, result.axis, trialSamples[t].data());
+            }
+        }
+
+        for (size_t t = 0; t < count; ++t) {
+            const size_t trial = begin + t;
+            const vector<double>& samples = trialSamples[t];
+            if (!trialOk[t]) {
+                failed[trial] = 1;
+                continue;
+            }
+            for (size_t k = 0; k < samples.size(); ++k) stats[k].add(samples[k]);
+            for (size_t o = 0; o < num_outputs; ++o) {
+                finalValues[trial * num_outputs + o] = samples[o * num_points + num_points - 1];
+            }
+        }
+        blockStats[begin / GRAIN] = move(stats);
+        setThreadQuiet(wasQuiet);
+    });
+
+    // Merge the blocks in trial order
+    vector<RunningStatistics> total(num_outputs * num_points);
+    for (const auto& block : blockStats) {
+        for (size_t k = 0; k < block.size(); ++k) total[k].merge(block[k]);
+    }
+
+    result.failedTrials = count(failed.begin(), failed.end(), 1);
+    result.completedTrials = options.trials - result.failedTrials;
+    int bins = max(1, options.histogramBins);
+    for (size_t o = 0; o < num_outputs; ++o) {
+        MonteCarloStatistics s;
+        s.output = options.outputs[o];
+        for (size_t p = 0; p < num_points; ++p) {
+            const RunningStatistics& r = total[o * num_points + p];
+            s.mean.push_back(r.count ? r.mean : numeric_limits<double>::quiet_NaN());
+            s.stddev.push_back(r.count > 1 ? sqrt(r.m2 / (r.count - 1)) : 0.0);
+            s.minimum.push_back(r.minimum);
+            s.maximum.push_back(r.maximum);
+        }
+
+        s.histogramMin = s.minimum.back();
+        s.histogramMax = s.maximum.back();
+        s.histogram.assign(bins, 0);
+        double width = (s.histogramMax - s.histogramMin) / bins;
+        for (int trial = 0; trial < options.trials; ++trial) {
+            double value = finalValues[trial * num_outputs + o];
+            if (failed[trial] || !isfinite(value)) continue;
+            int bin = width > 0.0 ? (int)((value - s.histogramMin) / width) : 0;
+            s.histogram[min(max(bin, 0), bins - 1)]++;
+        }
+        result.outputs.push_back(move(s));
+    }
+
+    analysisOutput() << "// Monte Carlo Analysis complete: " << result.completedTrials << " trials";
+    if (result.failedTrials > 0) analysisOutput() << ", " << result.failedTrials << " failed";
+    analysisOutput() << "." << endl;
+    return true;
+}
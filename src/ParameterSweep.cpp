@@ -0,0 +1,119 @@
+#include "Analysis.h"
+#include "ThreadPool.h"
+#include "BatchSimulator.h"
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+bool parameterSweepAnalysis(Circuit& circuit, const ParameterSweepOptions& options, ParameterSweepResult& result) {
+    result = ParameterSweepResult();
+    const vector<StepParameter> parameters = circuit.stepParameters;
+
+    size_t grid_points = 1;
+    for (const auto& p : parameters) grid_points *= p.values.size();
+    analysisOutput() << "// Performing Parameter Sweep (" << grid_points << " points over " << parameters.size() << " parameters)..." << endl;
+
+    if (parameters.empty() || grid_points == 0) {
+        analysisErrors() << "Error: Parameter sweep needs at least one parameter with at least one value." << endl;
+        return false;
+    }
+    for (const auto& p : parameters) {
+        if (!circuit.findComponentValue(p.component)) {
+            analysisErrors() << "Error: Parameter sweep over unknown component '" << p.component << "'." << endl;
+            return false;
+        }
+    }
+    if (!options.validate(circuit, options.outputs)) return false;
+
+    // Grid points start from a copy without stored results
+    Circuit base(circuit);
+    base.clearStoredResults();
+
+    result.parameters = parameters;
+    result.axis = options.axis();
+    result.outputs = options.outputs;
+    for (const auto& p : parameters) result.shape.push_back(p.values.size());
+    result.shape.push_back(result.axis.size());
+
+    const size_t num_outputs = options.outputs.size();
+    const size_t num_points = result.axis.size();
+    for (size_t o = 0; o < num_outputs; ++o) {
+        result.values.emplace_back(grid_points * num_points, numeric_limits<double>::quiet_NaN());
+    }
+
+    // Blocks run along the innermost parameter, so consecutive points of a block
+    // differ in one value and the worker's circuit carries its DC diode states and
+    // AC pivot order from one to the next. Blocks are shortened when there are
+    // too few of them to keep every worker busy.
+    // Linear circuits instead run every block as one lane batch.
+    ThreadPool& pool = ThreadPool::shared();
+    const bool batched = options.analysis != AnalysisType::AC_SWEEP && isBatchable(base);
+    const size_t inner = parameters.back().values.size();
+    const size_t grain = batched ? BATCH_LANES
+                                 : max<size_t>(1, min(inner, (grid_points + 4 * pool.size() - 1) / (4 * pool.size())));
+    vector<char> failed(grid_points, 0);
+    vector<string> names;
+    for (const auto& p : parameters) names.push_back(p.component);
+
+    // Row-major multi-index: the last parameter varies fastest
+    auto pointValues = [&](size_t point) {
+        vector<double> point_values(parameters.size());
+        for (size_t d = parameters.size(); d-- > 0;) {
+            point_values[d] = parameters[d].values[point % parameters[d].values.size()];
+            point /= parameters[d].values.size();
+        }
+        return point_values;
+    };
+    auto store = [&](size_t point, const double* samples) {
+        for (size_t o = 0; o < num_outputs; ++o) {
+            copy(samples + o * num_points, samples + (o + 1) * num_points, result.values[o].begin() + point * num_points);
+        }
+    };
+
+    pool.parallelForDynamic(grid_points, grain, [&](size_t begin, size_t end) {
+        // Points run quietly on every pool thread they land on
+        bool wasQuiet = setThreadQuiet(true);
+        if (batched) {
+            vector<vector<double>> laneValues;
+            for (size_t point = begin; point < end; ++point) laneValues.push_back(pointValues(point));
+            vector<vector<double>> laneSamples;
+            vector<char> laneOk;
+            if (batchedAnalysis(base, options, names, laneValues, options.outputs, laneSamples, laneOk)) {
+                for (size_t point = begin; point < end; ++point) {
+                    if (laneOk[point - begin]) store(point, laneSamples[point - begin].data());
+                    else failed[point] = 1;
+                }
+                setThreadQuiet(wasQuiet);
+                return;
+            }
+        }
+
+        Circuit c(base);
+        vector<double*> targets;
+        for (const auto& p : parameters) targets.push_back(c.findComponentValue(p.component));
+        vector<double> samples(num_outputs * num_points);
+
+        for (size_t point = begin; point < end; ++point) {
+            vector<double> point_values = pointValues(point);
+            for (size_t d = 0; d < parameters.size(); ++d) *targets[d] = point_values[d];
+
+            options.run(c, point != begin);
+            if (!options.sample(c, options.outputs, result.axis, samples.data())) {
+                failed[point] = 1;
+                continue;
+            }
+            store(point, samples.data());
+        }
+        setThreadQuiet(wasQuiet);
+    });
+
+    result.failedPoints = count(failed.begin(), failed.end(), 1);
+
+    analysisOutput() << "// Parameter Sweep complete: " << grid_points - result.failedPoints << " points";
+    if (result.failedPoints > 0) analysisOutput() << ", " << result.failedPoints << " failed";
+    analysisOutput() << "." << endl;
+    return true;
+}
@@ -0,0 +1,313 @@
+#include "ReducedOrderModel.h"
+#include "Circuit.h"
+#include "LinearSolver.h"
+#include "ThreadPool.h"
+#include "Fingerprint.h"
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool ReducedACModel::empty() const {
+    return basis.empty() || br.empty();
+}
+
+size_t ReducedACModel::order() const {
+    return br.size();
+}
+
+bool ReducedACModel::covers(double fmin, double fmax) const {
+    return !empty() && fmin >= minFrequency * (1.0 - 1e-12) && fmax <= maxFrequency * (1.0 + 1e-12);
+}
+
+bool ReducedACModel::evaluate(double frequency, vector<complex<double>>& x) const {
+    size_t q = order();
+    if (q == 0 || frequency <= 0.0) return false;
+
+    double omega = 2.0 * M_PI * frequency;
+    vector<vector<complex<double>>> Ar(q, vector<complex<double>>(q));
+    for (size_t i = 0; i < q; ++i) {
+        for (size_t j = 0; j < q; ++j) {
+            Ar[i][j] = complex<double>(Gr[i][j], omega * Cr[i][j] - Gammar[i][j] / omega);
+        }
+    }
+
+    vector<complex<double>> y;
+    try {
+        y = gaussianElimination(Ar, br);
+    } catch (const exception&) {
+        return false;
+    }
+
+    x.assign(basis.size(), {0.0, 0.0});
+    for (size_t r = 0; r < basis.size(); ++r) {
+        complex<double> sum(0.0, 0.0);
+        for (size_t k = 0; k < q; ++k) sum += basis[r][k] * y[k];
+        x[r] = sum;
+    }
+    return true;
+}
+
+bool ReducedACModel::save(const string& path) const {
+    ofstream out(path);
+    if (!out) return false;
+
+    out << setprecision(17);
+    out << "REDUCED_AC_MODEL 1\n";
+    out << "fingerprint " << fingerprint << "\n";
+    out << "range " << minFrequency << " " << maxFrequency << "\n";
+    out << "error " << errorEstimate << "\n";
+    out << "unknowns " << unknownNames.size() << "\n";
+    for (const auto& name : unknownNames) out << name << "\n";
+    out << "expansion " << expansionFrequencies.size();
+    for (double f : expansionFrequencies) out << " " << f;
+    out << "\n";
+
+    size_t q = order();
+    out << "order " << q << "\n";
+    for (const auto& row : basis) {
+        for (size_t k = 0; k < q; ++k) out << (k ? " " : "") << row[k];
+        out << "\n";
+    }
+    for (const auto* M : {&Gr, &Cr, &Gammar}) {
+        for (const auto& row : *M) {
+            for (size_t k = 0; k < q; ++k) out << (k ? " " : "") << row[k];
+            out << "\n";
+        }
+    }
+    for (const auto& v : br) out << v.real() << " " << v.imag() << "\n";
+    return static_cast<bool>(out);
+}
+
+bool ReducedACModel::load(const string& path) {
+    ifstream in(path);
+    if (!in) return false;
+
+    ReducedACModel m;
+    string tag;
+    int version = 0;
+    size_t n = 0, k = 0, q = 0;
+    if (!(in >> tag >> version) || tag != "REDUCED_AC_MODEL" || version != 1) return false;
+    if (!(in >> tag >> m.fingerprint) || tag != "fingerprint") return false;
+    if (!(in >> tag >> m.minFrequency >> m.maxFrequency) || tag != "range") return false;
+    if (!(in >> tag >> m.errorEstimate) || tag != "error") return false;
+    if (!(in >> tag >> n) || tag != "unknowns") return false;
+    in >> ws;
+    m.unknownNames.resize(n);
+    for (auto& name : m.unknownNames) {
+        if (!getline(in, name)) return false;
+    }
+    if (!(in >> tag >> k) || tag != "expansion") return false;
+    m.expansionFrequencies.resize(k);
+    for (auto& f : m.expansionFrequencies) in >> f;
+    if (!(in >> tag >> q) || tag != "order") return false;
+
+    m.basis.assign(n, vector<double>(q));
+    for (auto& row : m.basis) for (auto& v : row) in >> v;
+    for (auto* M : {&m.Gr, &m.Cr, &m.Gammar}) {
+        M->assign(q, vector<double>(q));
+        for (auto& row : *M) for (auto& v : row) in >> v;
+    }
+    m.br.resize(q);
+    for (auto& v : m.br) {
+        double re, im;
+        in >> re >> im;
+        v = complex<double>(re, im);
+    }
+    if (!in) return false;
+
+    *this = move(m);
+    return true;
+}
+
+uint64_t acSystemFingerprint(const ACSystemParts& parts, const vector<complex<double>>& rhs) {
+    Fingerprint hash;
+    hash.mix(static_cast<double>(parts.G.size()));
+    for (const auto& entry : parts.nonzeros) {
+        hash.mix(entry.first);
+        hash.mix(entry.second);
+        hash.mix(parts.G[entry.first][entry.second]);
+        hash.mix(parts.C[entry.first][entry.second]);
+        hash.mix(parts.Gamma[entry.first][entry.second]);
+    }
+    for (const auto& v : rhs) {
+        hash.mix(v.real());
+        hash.mix(v.imag());
+    }
+    return hash.value;
+}
+
+double acRelativeResidual(const ACSystemParts& parts, const vector<complex<double>>& rhs, double frequency, const vector<complex<double>>& x) {
+    double omega = 2.0 * M_PI * frequency;
+    vector<complex<double>> r(rhs);
+    for (const auto& entry : parts.nonzeros) {
+        int row = entry.first;
+        int col = entry.second;
+        complex<double> a(parts.G[row][col], omega * parts.C[row][col] - parts.Gamma[row][col] / omega);
+        r[row] -= a * x[col];
+    }
+    double r_norm = 0.0, b_norm = 0.0;
+    for (size_t i = 0; i < r.size(); ++i) {
+        r_norm += norm(r[i]);
+        b_norm += norm(rhs[i]);
+    }
+    return b_norm > 0.0 ? sqrt(r_norm / b_norm) : sqrt(r_norm);
+}
+
+// Solves the full system at one frequency, sparse first with a dense fallback
+static bool solveFullAC(const ACSystemParts& parts, double omega, const vector<complex<double>>& b, vector<complex<double>>& x) {
+    size_t n = parts.G.size();
+    vector<complex<double>> entries, lu;
+    parts.formEntries(omega, entries);
+    SparseLUPattern pattern = analyzeSparseLU(n, parts.nonzeros, entries);
+    pattern.load(entries, lu);
+    if (sparseLUSolve(pattern, lu, b, x)) return true;
+
+    vector<vector<complex<double>>> A(n, vector<complex<double>>(n, {0.0, 0.0}));
+    parts.form(omega, A);
+    try {
+        x = gaussianElimination(A, b);
+    } catch (const exception&) {
+        return false;
+    }
+    return true;
+}
+
+// Appends v to the orthonormal basis (modified Gram-Schmidt, two passes).
+// Vectors already inside the span are dropped.
+static void appendToBasis(vector<vector<double>>& columns, vector<double> v) {
+    const double DEFLATION_TOL = 1e-10;
+
+    double original = 0.0;
+    for (double value : v) original += value * value;
+    original = sqrt(original);
+    if (original == 0.0) return;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const auto& q : columns) {
+            double dot = 0.0;
+            for (size_t i = 0; i < v.size(); ++i) dot += q[i] * v[i];
+            for (size_t i = 0; i < v.size(); ++i) v[i] -= dot * q[i];
+        }
+    }
+
+    double remaining = 0.0;
+    for (double value : v) remaining += value * value;
+    remaining = sqrt(remaining);
+    if (remaining <= DEFLATION_TOL * original) return;
+
+    for (double& value : v) value /= remaining;
+    columns.push_back(move(v));
+}
+
+// V' M V over the nonzero pattern of M
+static vector<vector<double>> projectMatrix(const vector<vector<double>>& M, const vector<pair<int, int>>& nonzeros,
+                                            const vector<vector<double>>& columns) {
+    size_t q = columns.size();
+    vector<vector<double>> result(q, vector<double>(q, 0.0));
+    for (const auto& entry : nonzeros) {
+        double value = M[entry.first][entry.second];
+        if (value == 0.0) continue;
+        for (size_t i = 0; i < q; ++i) {
+            double left = columns[i][entry.first] * value;
+            if (left == 0.0) continue;
+            for (size_t j = 0; j < q; ++j) {
+                result[i][j] += left * columns[j][entry.second];
+            }
+        }
+    }
+    return result;
+}
+
+bool buildReducedACModel(const ACSystemParts& parts, const vector<complex<double>>& rhs, double fmin, double fmax,
+                         ReducedACModel& model, double tolerance) {
+    const int MAX_EXPANSION_POINTS = 16;
+    const int TRAINING_POINTS = 64;
+
+    size_t n = parts.G.size();
+    if (n == 0 || fmin <= 0.0 || fmax < fmin) return false;
+
+    vector<double> training;
+    for (int i = 0; i < TRAINING_POINTS; ++i) {
+        training.push_back(fmin * pow(fmax / fmin, (double)i / (double)(TRAINING_POINTS - 1)));
+    }
+
+    vector<vector<double>> columns; // Basis vectors, each of length n
+    vector<double> expansions;
+    double next = sqrt(fmin * fmax);
+    double worst = numeric_limits<double>::infinity();
+
+    for (int point = 0; point < MAX_EXPANSION_POINTS; ++point) {
+        // Moments at s0 = jw0: x0 = A^-1 b and x1 = -A^-1 A'(s0) x0, A'(s) = C - Gamma/s^2
+        double omega0 = 2.0 * M_PI * next;
+        complex<double> s0(0.0, omega0);
+        vector<complex<double>> x0, x1;
+        if (!solveFullAC(parts, omega0, rhs, x0)) break;
+        vector<complex<double>> dA_x0(n, {0.0, 0.0});
+        for (const auto& entry : parts.nonzeros) {
+            int r = entry.first;
+            int c = entry.second;
+            dA_x0[r] -= (parts.C[r][c] - parts.Gamma[r][c] / (s0 * s0)) * x0[c];
+        }
+        if (!solveFullAC(parts, omega0, dA_x0, x1)) break;
+        expansions.push_back(next);
+
+        // Real and imaginary parts keep the projection real
+        for (const auto* x : {&x0, &x1}) {
+            vector<double> re(n), im(n);
+            for (size_t i = 0; i < n; ++i) {
+                re[i] = (*x)[i].real();
+                im[i] = (*x)[i].imag();
+            }
+            appendToBasis(columns, move(re));
+            appendToBasis(columns, move(im));
+        }
+
+        size_t q = columns.size();
+        model.basis.assign(n, vector<double>(q));
+        for (size_t k = 0; k < q; ++k) {
+            for (size_t i = 0; i < n; ++i) model.basis[i][k] = columns[k][i];
+        }
+        model.Gr = projectMatrix(parts.G, parts.nonzeros, columns);
+        model.Cr = projectMatrix(parts.C, parts.nonzeros, columns);
+        model.Gammar = projectMatrix(parts.Gamma, parts.nonzeros, columns);
+        model.br.assign(q, {0.0, 0.0});
+        for (size_t k = 0; k < q; ++k) {
+            for (size_t i = 0; i < n; ++i) model.br[k] += columns[k][i] * rhs[i];
+        }
+
+        // Residual over the training grid; the worst point becomes the next expansion
+        vector<double> residuals(training.size(), numeric_limits<double>::infinity());
+        ThreadPool::shared().parallelFor(training.size(), [&](size_t begin, size_t end) {
+            vector<complex<double>> x;
+            for (size_t i = begin; i < end; ++i) {
+                if (model.evaluate(training[i], x)) {
+                    residuals[i] = acRelativeResidual(parts, rhs, training[i], x);
+                }
+            }
+        });
+        size_t worst_index = max_element(residuals.begin(), residuals.end()) - residuals.begin();
+        worst = residuals[worst_index];
+        if (worst <= tolerance) break;
+
+        next = training[worst_index];
+        if (find(expansions.begin(), expansions.end(), next) != expansions.end()) break;
+    }
+
+    if (columns.empty()) return false;
+
+    model.expansionFrequencies = expansions;
+    model.minFrequency = fmin;
+    model.maxFrequency = fmax;
+    model.errorEstimate = worst;
+    model.fingerprint = acSystemFingerprint(parts, rhs);
+    return true;
+}
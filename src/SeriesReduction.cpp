@@ -0,0 +1,188 @@
+#include "SeriesReduction.h"
+#include "LinearSolver.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+atomic<bool> seriesReduction(false);
+
+// Smallest pivot accepted, relative to the largest off-diagonal entry of its row
+const double PIVOT_RATIO = 1e-3;
+
+template <typename T>
+bool reduceSystem(const SeriesReduction& r, vector<vector<T>>& A, vector<T>& b,
+                  vector<vector<T>>& A_reduced, vector<T>& b_reduced) {
+    for (size_t e = 0; e < r.order.size(); ++e) {
+        const int i = r.order[e];
+        const vector<int>& adjacent = r.neighbours[e];
+        const T pivot = A[i][i];
+        double largest = 0.0;
+        for (int j : adjacent) largest = max(largest, (double)abs(A[i][j]));
+        if (pivot == T(0) || abs(pivot) < PIVOT_RATIO * largest) return false;
+
+        for (int j : adjacent) {
+            T factor = A[j][i] / pivot;
+            if (factor == T(0)) continue;
+            for (int k : adjacent) A[j][k] -= factor * A[i][k];
+            b[j] -= factor * b[i];
+        }
+    }
+
+    A_reduced.assign(r.reduced, vector<T>(r.reduced, T(0)));
+    b_reduced.assign(r.reduced, T(0));
+    for (const auto& [p, q] : r.nonzeros) A_reduced[p][q] = A[r.kept[p]][r.kept[q]];
+    for (int p = 0; p < r.reduced; ++p) b_reduced[p] = b[r.kept[p]];
+    return true;
+}
+
+template <typename T>
+vector<T> expandSystem(const SeriesReduction& r, const vector<vector<T>>& A, const vector<T>& b, const vector<T>& y) {
+    vector<T> x(r.unknowns, T(0));
+    for (int p = 0; p < r.reduced; ++p) x[r.kept[p]] = y[p];
+    for (size_t e = r.order.size(); e-- > 0;) {
+        const int i = r.order[e];
+        T sum = b[i];
+        for (int j : r.neighbours[e]) sum -= A[i][j] * x[j];
+        x[i] = sum / A[i][i];
+    }
+    return x;
+}
+
+} // namespace
+
+bool SeriesReduction::build(const vector<pair<int, int>>& pattern, int size, int nodes) {
+    unknowns = size;
+    order.clear();
+    neighbours.clear();
+
+    vector<vector<int>> adjacency(size);
+    vector<char> diagonal(size, 0);
+    for (const auto& [i, j] : pattern) {
+        if (i == j) diagonal[i] = 1;
+        else adjacency[i].push_back(j);
+    }
+    // Only structurally symmetric node rows qualify; branch rows have no pivot of their own
+    vector<char> candidate(size, 0);
+    for (int i = 0; i < size; ++i) {
+        sort(adjacency[i].begin(), adjacency[i].end());
+        adjacency[i].erase(unique(adjacency[i].begin(), adjacency[i].end()), adjacency[i].end());
+    }
+    for (int i = 0; i < nodes && i < size; ++i) {
+        candidate[i] = diagonal[i];
+        for (int j : adjacency[i]) {
+            if (!binary_search(adjacency[j].begin(), adjacency[j].end(), i)) candidate[i] = 0;
+        }
+    }
+    for (int i = 0; i < size; ++i) {
+        for (int j : adjacency[i]) {
+            if (!binary_search(adjacency[j].begin(), adjacency[j].end(), i)) candidate[j] = 0;
+        }
+    }
+
+    vector<char> eliminated(size, 0);
+    vector<int> queue;
+    for (int i = 0; i < size; ++i) {
+        if (candidate[i] && adjacency[i].size() <= 2) queue.push_back(i);
+    }
+    for (size_t q = 0; q < queue.size(); ++q) {
+        const int i = queue[q];
+        if (eliminated[i] || adjacency[i].size() > 2) continue;
+        eliminated[i] = 1;
+        order.push_back(i);
+        neighbours.push_back(adjacency[i]);
+
+        // Ends of the chain now meet directly; their degree cannot grow
+        const vector<int>& adjacent = neighbours.back();
+        for (int j : adjacent) {
+            auto& list = adjacency[j];
+            list.erase(find(list.begin(), list.end(), i));
+            for (int k : adjacent) {
+                if (k != j && find(list.begin(), list.end(), k) == list.end()) list.push_back(k);
+            }
+            diagonal[j] = 1;
+            if (candidate[j] && !eliminated[j] && list.size() <= 2) queue.push_back(j);
+        }
+    }
+    if (order.empty()) return false;
+
+    kept.clear();
+    vector<int> position(size, -1);
+    for (int i = 0; i < size; ++i) {
+        if (eliminated[i]) continue;
+        position[i] = kept.size();
+        kept.push_back(i);
+    }
+    reduced = kept.size();
+    nonzeros.clear();
+    for (int i : kept) {
+        if (diagonal[i]) nonzeros.push_back({position[i], position[i]});
+        for (int j : adjacency[i]) nonzeros.push_back({position[i], position[j]});
+    }
+    sort(nonzeros.begin(), nonzeros.end());
+    return true;
+}
+
+bool SeriesReduction::reduce(vector<vector<double>>& A, vector<double>& b,
+                             vector<vector<double>>& A_reduced, vector<double>& b_reduced) const {
+    return reduceSystem(*this, A, b, A_reduced, b_reduced);
+}
+
+bool SeriesReduction::reduce(vector<vector<complex<double>>>& A, vector<complex<double>>& b,
+                             vector<vector<complex<double>>>& A_reduced, vector<complex<double>>& b_reduced) const {
+    return reduceSystem(*this, A, b, A_reduced, b_reduced);
+}
+
+vector<double> SeriesReduction::expand(const vector<vector<double>>& A, const vector<double>& b, const vector<double>& y) const {
+    return expandSystem(*this, A, b, y);
+}
+
+vector<complex<double>> SeriesReduction::expand(const vector<vector<complex<double>>>& A, const vector<complex<double>>& b,
+                                                const vector<complex<double>>& y) const {
+    return expandSystem(*this, A, b, y);
+}
+
+void setSeriesReduction(bool enabled) {
+    seriesReduction = enabled;
+}
+
+bool seriesReductionEnabled() {
+    return seriesReduction;
+}
+
+vector<double> solveSeriesReduced(const vector<vector<double>>& A, const vector<double>& b, int nodes, int* solved) {
+    const int n = A.size();
+    if (solved) *solved = n;
+    if (!seriesReduction) return gaussianElimination(A, b);
+
+    // The order is rebuilt only when the nonzero pattern changes, which in DC
+    // and transient solves it does only when a diode switches
+    thread_local vector<pair<int, int>> pattern, cachedPattern;
+    thread_local SeriesReduction reduction;
+    thread_local int cachedUnknowns = -1, cachedNodes = -1;
+    thread_local bool applies = false;
+    pattern.clear();
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            if (A[i][j] != 0.0) pattern.push_back({i, j});
+        }
+    }
+    if (n != cachedUnknowns || nodes != cachedNodes || pattern != cachedPattern) {
+        reduction = SeriesReduction();
+        applies = reduction.build(pattern, n, nodes);
+        cachedPattern.swap(pattern);
+        cachedUnknowns = n;
+        cachedNodes = nodes;
+    }
+    if (!applies) return gaussianElimination(A, b);
+
+    vector<vector<double>> work = A, A_reduced;
+    vector<double> rhs = b, b_reduced;
+    if (!reduction.reduce(work, rhs, A_reduced, b_reduced)) return gaussianElimination(A, b);
+    if (solved) *solved = reduction.reduced;
+    vector<double> y = reduction.reduced > 0 ? gaussianElimination(A_reduced, b_reduced) : vector<double>();
+    return reduction.expand(work, rhs, y);
+}
@@ -0,0 +1,184 @@
+#include "SupernodeReduction.h"
+#include "LinearSolver.h"
+#include "SeriesReduction.h"
+#include "UnionFind.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// An inductor row at the DC step carries -L/dt, around 1e-15 L
+const double SHORT_TOLERANCE = 1e-12;
+
+// Terminals and signs of branch k if its row and column are those of a voltage
+// constraint: row k reads s1 x_n1 + s2 x_n2 = b_k with s2 = -s1, column k
+// holds the opposite incidence in the KCL rows n1 and n2 and nothing else.
+// n2 is -1 for a grounded branch.
+bool constraintBranch(const vector<vector<double>>& A, int nodes, int k, int& n1, int& n2, double& s1) {
+    const int N = A.size();
+    if (abs(A[k][k]) > SHORT_TOLERANCE) return false;
+    n1 = n2 = -1;
+    for (int j = 0; j < N; ++j) {
+        double a = A[k][j];
+        if (a == 0.0 || j == k) continue;
+        if (j >= nodes || abs(a) != 1.0 || n2 != -1) return false;
+        (n1 == -1 ? n1 : n2) = j;
+    }
+    if (n1 == -1) return false;
+    s1 = A[k][n1];
+    if (n2 != -1 && A[k][n2] != -s1) return false;
+    for (int i = 0; i < N; ++i) {
+        double a = A[i][k];
+        if (i == k || a == 0.0) continue;
+        if (i != n1 && i != n2) return false;
+        if (a != A[k][i]) return false;
+    }
+    return true;
+}
+
+// Written by every solveMNA for its caller's log line
+thread_local MNAReductionSizes lastSizes;
+
+} // namespace
+
+bool SupernodeReduction::build(const vector<vector<double>>& A, int node_count) {
+    nodes = node_count;
+    unknowns = A.size();
+    const int ground = nodes;
+
+    // Spanning forest of the constraint branches, ground as one more vertex
+    UnionFind sets(nodes + 1);
+    vector<vector<pair<int, int>>> adjacency(nodes + 1); // (neighbour, branch)
+    vector<double> rowSign(unknowns, 0.0);
+    vector<int> positive(unknowns, -1); // Node of branch k whose row entry is rowSign[k]
+    vector<char> eliminated(unknowns, 0);
+    for (int k = nodes; k < unknowns; ++k) {
+        int n1, n2;
+        double s1;
+        if (!constraintBranch(A, nodes, k, n1, n2, s1)) continue;
+        int other = n2 != -1 ? n2 : ground;
+        if (!sets.unite(n1, other)) return false;
+        adjacency[n1].push_back({other, k});
+        adjacency[other].push_back({n1, k});
+        rowSign[k] = s1;
+        positive[k] = n1;
+        eliminated[k] = 1;
+    }
+    if (find(eliminated.begin(), eliminated.end(), 1) == eliminated.end()) return false;
+
+    // Breadth-first from ground, then from the lowest node of every other supernode
+    edges.clear();
+    vector<int> parent(nodes + 1, -2);
+    vector<int> root(nodes + 1, -1);
+    auto traverse = [&](int start) {
+        parent[start] = -1;
+        root[start] = start;
+        vector<int> queue{start};
+        for (size_t q = 0; q < queue.size(); ++q) {
+            int u = queue[q];
+            for (auto [v, k] : adjacency[u]) {
+                if (parent[v] != -2) continue;
+                parent[v] = u;
+                root[v] = start;
+                // Row k: s (x_n1 - x_n2) = b_k, so x_v = x_u + sign * b_k
+                double sign = (v == positive[k] ? 1.0 : -1.0) * rowSign[k];
+                edges.push_back({v, u == ground ? -1 : u, k, sign});
+                queue.push_back(v);
+            }
+        }
+    };
+    traverse(ground);
+    for (int i = 0; i < nodes; ++i) {
+        if (parent[i] == -2) traverse(i);
+    }
+
+    column.assign(unknowns, -1);
+    rows.clear();
+    for (int i = 0; i < nodes; ++i) {
+        if (root[i] == ground) continue;
+        if (root[i] == i) {
+            column[i] = rows.size();
+            rows.emplace_back();
+        }
+    }
+    for (int i = 0; i < nodes; ++i) {
+        if (root[i] == ground) continue;
+        column[i] = column[root[i]];
+        rows[column[i]].push_back(i);
+    }
+    reducedNodes = rows.size();
+    for (int k = nodes; k < unknowns; ++k) {
+        if (eliminated[k]) continue;
+        column[k] = rows.size();
+        rows.push_back({k});
+    }
+    reduced = rows.size();
+    return true;
+}
+
+// Voltage of every node relative to its supernode's root, or absolute under ground
+vector<double> SupernodeReduction::offsets(const vector<double>& b) const {
+    vector<double> offset(nodes, 0.0);
+    for (const Edge& e : edges) {
+        offset[e.child] = (e.parent == -1 ? 0.0 : offset[e.parent]) + e.sign * b[e.branch];
+    }
+    return offset;
+}
+
+void SupernodeReduction::reduce(const vector<vector<double>>& A, const vector<double>& b,
+                                vector<vector<double>>& A_reduced, vector<double>& b_reduced) const {
+    vector<double> offset = offsets(b);
+    A_reduced.assign(reduced, vector<double>(reduced, 0.0));
+    b_reduced.assign(reduced, 0.0);
+    for (int r = 0; r < reduced; ++r) {
+        for (int i : rows[r]) {
+            double rhs = b[i];
+            for (int j = 0; j < unknowns; ++j) {
+                double a = A[i][j];
+                if (a == 0.0) continue;
+                if (j < nodes) rhs -= a * offset[j];
+                if (column[j] != -1) A_reduced[r][column[j]] += a;
+            }
+            b_reduced[r] += rhs;
+        }
+    }
+}
+
+vector<double> SupernodeReduction::expand(const vector<vector<double>>& A, const vector<double>& b,
+                                          const vector<double>& y) const {
+    vector<double> offset = offsets(b);
+    vector<double> x(unknowns, 0.0);
+    for (int j = 0; j < unknowns; ++j) {
+        if (column[j] != -1) x[j] = y[column[j]];
+        if (j < nodes) x[j] += offset[j];
+    }
+
+    // Leaves first, each eliminated current balances the KCL row of its child
+    for (auto e = edges.rbegin(); e != edges.rend(); ++e) {
+        double residual = b[e->child];
+        for (int j = 0; j < unknowns; ++j) {
+            if (j != e->branch) residual -= A[e->child][j] * x[j];
+        }
+        x[e->branch] = residual / A[e->child][e->branch];
+    }
+    return x;
+}
+
+vector<double> solveMNA(const vector<vector<double>>& A, const vector<double>& b, int nodes) {
+    lastSizes.unknowns = lastSizes.supernodes = A.size();
+    SupernodeReduction reduction;
+    if (!reduction.build(A, nodes)) return solveSeriesReduced(A, b, nodes, &lastSizes.series);
+
+    vector<vector<double>> A_reduced;
+    vector<double> b_reduced;
+    reduction.reduce(A, b, A_reduced, b_reduced);
+    lastSizes.supernodes = lastSizes.series = reduction.reduced;
+    vector<double> y = reduction.reduced > 0 ? solveSeriesReduced(A_reduced, b_reduced, reduction.reducedNodes, &lastSizes.series) : vector<double>();
+    return reduction.expand(A, b, y);
+}
+
+MNAReductionSizes lastMNAReductionSizes() {
+    return lastSizes;
+}
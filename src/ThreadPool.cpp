@@ -0,0 +1,134 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+#include <atomic>
+
+using namespace std;
+
+namespace {
+    thread_local bool insideWorker = false;
+}
+
+ThreadPool::ThreadPool(size_t num_threads) : stopping(false) {
+    if (num_threads == 0) {
+        num_threads = max(1u, thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+void ThreadPool::enqueue(function<void()> task) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        tasks.push(move(task));
+    }
+    queueCondition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    insideWorker = true;
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t, size_t)>& body) {
+    size_t chunks = min(count, workers.size());
+    if (chunks <= 1 || insideWorker) {
+        if (count > 0) body(0, count);
+        return;
+    }
+
+    mutex doneMutex;
+    condition_variable doneCondition;
+    size_t remaining = chunks;
+    exception_ptr failure;
+
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t begin = count * c / chunks;
+        size_t end = count * (c + 1) / chunks;
+        enqueue([&, begin, end] {
+            exception_ptr error;
+            try {
+                body(begin, end);
+            } catch (...) {
+                error = current_exception();
+            }
+            lock_guard<mutex> lock(doneMutex);
+            if (error && !failure) failure = error;
+            if (--remaining == 0) doneCondition.notify_one();
+        });
+    }
+
+    unique_lock<mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&] { return remaining == 0; });
+    if (failure) rethrow_exception(failure);
+}
+
+void ThreadPool::parallelForDynamic(size_t count, size_t grain, const function<void(size_t, size_t)>& body) {
+    if (grain == 0) grain = 1;
+    size_t blocks = (count + grain - 1) / grain;
+    size_t runners = min(blocks, workers.size());
+    if (runners <= 1 || insideWorker) {
+        for (size_t b = 0; b < blocks; ++b) {
+            body(b * grain, min(count, (b + 1) * grain));
+        }
+        return;
+    }
+
+    atomic<size_t> nextBlock(0);
+    mutex doneMutex;
+    condition_variable doneCondition;
+    size_t remaining = runners;
+    exception_ptr failure;
+
+    for (size_t r = 0; r < runners; ++r) {
+        enqueue([&] {
+            exception_ptr error;
+            try {
+                for (size_t b = nextBlock++; b < blocks; b = nextBlock++) {
+                    body(b * grain, min(count, (b + 1) * grain));
+                }
+            } catch (...) {
+                error = current_exception();
+                nextBlock = blocks; // Stop handing out work
+            }
+            lock_guard<mutex> lock(doneMutex);
+            if (error && !failure) failure = error;
+            if (--remaining == 0) doneCondition.notify_one();
+        });
+    }
+
+    unique_lock<mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&] { return remaining == 0; });
+    if (failure) rethrow_exception(failure);
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,178 @@
+#include "Analysis.h"
+#include "UnionFind.h"
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+atomic<FloatingNodePolicy> policy(FloatingNodePolicy::ADD_GMIN);
+
+// Lists at most this many names in a description
+const size_t MAX_LISTED = 10;
+
+string joinNames(const vector<string>& names) {
+    string text;
+    for (size_t i = 0; i < names.size() && i < MAX_LISTED; ++i) {
+        if (i > 0) text += ", ";
+        text += names[i];
+    }
+    if (names.size() > MAX_LISTED) text += " and " + to_string(names.size() - MAX_LISTED) + " more";
+    return text;
+}
+
+struct Edge {
+    int a;
+    int b;
+    string name;
+};
+
+} // namespace
+
+string TopologyIssue::describe() const {
+    switch (type) {
+        case TopologyIssueType::FLOATING_NODES:
+            return "Node(s) " + joinNames(nodes) + " have no conducting path to ground" +
+                   (fixed ? ", tied to ground through gmin." : ".");
+        case TopologyIssueType::VOLTAGE_LOOP:
+            return "Voltage source loop: " + joinNames(elements) + ".";
+        case TopologyIssueType::CURRENT_CUTSET:
+            return "Current source(s) " + joinNames(elements) + " are the only path into node(s) " + joinNames(nodes) +
+                   (fixed ? ", tied to ground through gmin." : ".");
+    }
+    return "";
+}
+
+string TopologyReport::describe() const {
+    string text;
+    for (const auto& issue : issues) {
+        if (!text.empty()) text += "\n";
+        text += issue.describe();
+    }
+    return text;
+}
+
+void setFloatingNodePolicy(FloatingNodePolicy p) {
+    policy = p;
+}
+
+FloatingNodePolicy floatingNodePolicy() {
+    return policy;
+}
+
+TopologyReport checkTopology(const Circuit& circuit, AnalysisType type, bool tieAllFloating) {
+    TopologyReport report;
+
+    // Vertices are the matrix indices of the nodes, ground is one more
+    vector<string> names;
+    unordered_map<int, int> index;
+    for (const Node* node : circuit.nodes) {
+        if (node->isGround) continue;
+        index[node->num] = names.size();
+        names.push_back(node->name);
+    }
+    const int ground = names.size();
+    auto vertex = [&](const Node* node) {
+        if (!node || node->isGround) return ground;
+        auto it = index.find(node->num);
+        return it == index.end() ? ground : it->second;
+    };
+
+    // Constraint branches fix a voltage difference; conductances only join their nodes.
+    // Diodes count as conductances whatever their state, as the state loop may switch them on.
+    vector<Edge> constraints, conductances, currents;
+    for (const auto& vs : circuit.voltageSources) constraints.push_back({vertex(vs.node1), vertex(vs.node2), vs.name});
+    for (const auto& r : circuit.resistors) conductances.push_back({vertex(r.node1), vertex(r.node2), r.name});
+    for (const auto& d : circuit.diodes) conductances.push_back({vertex(d.node1), vertex(d.node2), d.name});
+    for (const auto& ind : circuit.inductors) {
+        Edge e{vertex(ind.node1), vertex(ind.node2), ind.name};
+        // A DC inductor is a short; one across a single node shorts nothing
+        if (type == AnalysisType::DC && e.a != e.b) constraints.push_back(e);
+        else conductances.push_back(e);
+    }
+    if (type != AnalysisType::DC) {
+        for (const auto& cap : circuit.capacitors) conductances.push_back({vertex(cap.node1), vertex(cap.node2), cap.name});
+    }
+    if (type == AnalysisType::AC_SWEEP) {
+        for (const auto& src : circuit.acVoltageSources) constraints.push_back({vertex(src.node1), vertex(src.node2), src.name});
+    } else {
+        // Open for small signals
+        for (const auto& cs : circuit.currentSources) currents.push_back({vertex(cs.node1), vertex(cs.node2), cs.name});
+    }
+
+    // Voltage loops: a constraint joining two vertices its spanning forest already
+    // connects closes a loop with the tree path between them
+    UnionFind forest(ground + 1);
+    vector<vector<pair<int, int>>> tree(ground + 1); // (neighbour, constraint)
+    for (size_t k = 0; k < constraints.size(); ++k) {
+        const Edge& e = constraints[k];
+        if (forest.unite(e.a, e.b)) {
+            tree[e.a].push_back({e.b, (int)k});
+            tree[e.b].push_back({e.a, (int)k});
+            continue;
+        }
+        TopologyIssue issue;
+        issue.type = TopologyIssueType::VOLTAGE_LOOP;
+        vector<int> via(ground + 1, -1);
+        vector<int> from(ground + 1, -1);
+        vector<int> queue{e.a};
+        from[e.a] = e.a;
+        for (size_t q = 0; q < queue.size() && from[e.b] == -1; ++q) {
+            for (auto [v, c] : tree[queue[q]]) {
+                if (from[v] != -1) continue;
+                from[v] = queue[q];
+                via[v] = c;
+                queue.push_back(v);
+            }
+        }
+        for (int v = e.b; v != e.a; v = from[v]) issue.elements.push_back(constraints[via[v]].name);
+        issue.elements.push_back(e.name);
+        report.issues.push_back(issue);
+        report.rejected = true;
+    }
+
+    // Floating groups: components of the constraint and conductance graph away from ground
+    UnionFind groups(ground + 1);
+    for (const auto& e : constraints) groups.unite(e.a, e.b);
+    for (const auto& e : conductances) groups.unite(e.a, e.b);
+    const int groundRoot = groups.find(ground);
+
+    vector<int> issueOf(ground + 1, -1);
+    vector<TopologyIssue> floating;
+    vector<int> anchor;
+    for (int i = 0; i < ground; ++i) {
+        int root = groups.find(i);
+        if (root == groundRoot) continue;
+        if (issueOf[root] == -1) {
+            issueOf[root] = floating.size();
+            floating.emplace_back();
+            floating.back().type = TopologyIssueType::FLOATING_NODES;
+            anchor.push_back(i);
+        }
+        floating[issueOf[root]].nodes.push_back(names[i]);
+    }
+    // A current source between two groups leaves the floating one(s) with a net injection
+    for (const auto& e : currents) {
+        int r1 = groups.find(e.a), r2 = groups.find(e.b);
+        if (r1 == r2) continue;
+        for (int root : {r1, r2}) {
+            if (root == groundRoot) continue;
+            TopologyIssue& issue = floating[issueOf[root]];
+            issue.type = TopologyIssueType::CURRENT_CUTSET;
+            issue.elements.push_back(e.name);
+        }
+    }
+    for (size_t g = 0; g < floating.size(); ++g) {
+        TopologyIssue& issue = floating[g];
+        if (tieAllFloating || (issue.type == TopologyIssueType::FLOATING_NODES && policy == FloatingNodePolicy::ADD_GMIN)) {
+            issue.fixed = true;
+            report.shuntNodes.push_back(anchor[g]);
+        } else {
+            report.rejected = true;
+        }
+        report.issues.push_back(issue);
+    }
+    return report;
+}
@@ -0,0 +1,529 @@
+#include "WaveformRelaxation.h"
+#include "LinearSolver.h"
+#include "CompanionModel.h"
+#include "ThreadPool.h"
+#include "UnionFind.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+// Weak resistor from a local node to a node of another partition, whose
+// voltage is read from that partition's waveform
+struct Coupling {
+    int local;
+    int remote; // Circuit matrix index
+    double g;
+};
+
+// Solution of one partition at its own step points. Times count output steps.
+struct Waveform {
+    vector<long long> times;
+    vector<vector<double>> values;
+
+    // Unknown i at time t, linear between step points
+    double at(long long t, int i) const {
+        auto it = upper_bound(times.begin(), times.end(), t);
+        if (it == times.begin()) return values.front()[i];
+        if (it == times.end()) return values.back()[i];
+        size_t k = it - times.begin();
+        double w = (double)(t - times[k - 1]) / (times[k] - times[k - 1]);
+        return values[k - 1][i] + w * (values[k][i] - values[k - 1][i]);
+    }
+};
+
+// Integration state a partition carries from one window into the next
+struct PartitionState {
+    vector<double> x;      // Solution at the window start
+    vector<double> x_prev; // Solution one step before that
+    long long h_prev = 0;
+    long long steps = 0;   // Steps integrated so far; the truncation error needs two
+    int level = 0;         // Next step is 2^level output steps
+    long long integrated = 0; // Time x belongs to; bypassed windows do not advance it
+    vector<double> inputs;    // Coupled remote voltages at that time
+    vector<double> capVoltage;
+    vector<double> indCurrent;
+};
+
+// Unknowns are ordered as in the MNA system of the whole circuit, restricted
+// to the partition: its nodes, its voltage source currents, its inductor currents
+struct Partition : CompanionTopology {
+    vector<int> nodes;    // Circuit matrix indices
+    vector<int> boundary; // Local nodes read by other partitions
+    vector<double> conductance, capacitance, inductance, voltage, current;
+    vector<int> voltageSourceIndex, inductorIndex; // Positions in the circuit
+    vector<Coupling> couplings;
+    map<int, LUFactorization> factors; // Backward Euler matrix by step level
+
+    // Component values and the state of the previous step, as stampCompanionMatrix/RHS read them
+    struct Stamp {
+        const Partition& p;
+        const PartitionState* s;
+        double conductance(size_t i) const { return p.conductance[i]; }
+        double capacitance(size_t i) const { return p.capacitance[i]; }
+        double inductance(size_t i) const { return p.inductance[i]; }
+        double voltage(size_t i) const { return p.voltage[i]; }
+        double current(size_t i) const { return p.current[i]; }
+        double capVoltage(size_t i) const { return s->capVoltage[i]; }
+        double indCurrent(size_t i) const { return s->indCurrent[i]; }
+    };
+    struct Matrix {
+        vector<vector<double>>& A;
+        void add(int i, int j, double g) { A[i][j] += g; }
+        void set(int i, int j, double value) { A[i][j] = value; }
+    };
+    struct Vector {
+        vector<double>& b;
+        void add(int i, double value) { b[i] += value; }
+    };
+
+    // Components stamped at every step, couplings included
+    long long devices() const {
+        return resistors.size() + capacitors.size() + inductors.size() + voltageSources.size() +
+               currentSources.size() + couplings.size();
+    }
+
+    const LUFactorization& factor(int level, double h, double gmin) {
+        auto it = factors.find(level);
+        if (it != factors.end()) return it->second;
+
+        vector<vector<double>> A(N, vector<double>(N, 0.0));
+        Matrix into{A};
+        stampCompanionMatrix(*this, h, Stamp{*this, nullptr}, into);
+        for (const Coupling& c : couplings) A[c.local][c.local] += c.g;
+        for (int i = 0; i < n; ++i) A[i][i] += gmin;
+        return factors[level] = luFactorize(move(A));
+    }
+
+    // remote(node, t) is the voltage of a node of another partition at time t
+    template <typename Remote>
+    vector<double> rhs(const PartitionState& s, double h, long long t, const Remote& remote) const {
+        vector<double> b(N, 0.0);
+        Vector into{b};
+        stampCompanionRHS(*this, h, Stamp{*this, &s}, into);
+        for (const Coupling& c : couplings) b[c.local] += c.g * remote(c.remote, t);
+        return b;
+    }
+};
+
+double nodeVoltage(const vector<double>& x, int i) {
+    return i != -1 ? x[i] : 0.0;
+}
+
+// A partition is latent over (t0, t1] when its last step, extrapolated from
+// the time it was last integrated to t1, moves no unknown by more than
+// tolerance and every node it reads from other partitions stays within
+// tolerance of its voltage at that time. Sources are constant in the
+// transient, so those are all of its inputs. Measuring from the last
+// integration rather than the window start makes drift that is small per
+// window add up until the partition is integrated again, which then starts
+// from that time.
+template <typename Remote>
+bool isLatent(const Partition& p, const PartitionState& s, long long t0, long long t1, const Remote& remote,
+              double tolerance) {
+    if (s.steps < 2) return false;
+    for (int i = 0; i < p.N; ++i) {
+        if (abs(s.x[i] - s.x_prev[i]) / s.h_prev * (t1 - s.integrated) > tolerance) return false;
+    }
+    for (size_t k = 0; k < p.couplings.size(); ++k) {
+        for (long long t = t0 + 1; t <= t1; ++t) {
+            if (abs(remote(p.couplings[k].remote, t) - s.inputs[k]) > tolerance) return false;
+        }
+    }
+    return true;
+}
+
+// Integrates partition p over (t0, t1] from state s, which advances to t1.
+// Returns the number of accepted steps; solves counts rejected ones as well.
+template <typename Remote>
+long long integrate(Partition& p, PartitionState& s, long long t0, long long t1, const Remote& remote,
+                    const WaveformRelaxationOptions& options, double gmin, Waveform& wave, long long& solves) {
+    const int m = p.nodes.size();
+    wave.times.assign(1, t0);
+    wave.values.assign(1, s.x);
+
+    long long t = t0;
+    long long accepted = 0;
+    while (t < t1) {
+        int level = s.level;
+        while ((1LL << level) > t1 - t) level--;
+        const long long h_steps = 1LL << level;
+        const double h = ldexp(options.t_step, level);
+
+        vector<double> x = luSolve(p.factor(level, h, gmin), p.rhs(s, h, t + h_steps, remote));
+        solves++;
+
+        // Backward Euler error h^2/2 |v''| from the last three points
+        double error = 0.0;
+        if (s.steps >= 2) {
+            for (int i = 0; i < m; ++i) {
+                double d1 = (x[i] - s.x[i]) / h_steps;
+                double d0 = (s.x[i] - s.x_prev[i]) / s.h_prev;
+                error = max(error, (double)h_steps * h_steps / (h_steps + s.h_prev) * abs(d1 - d0));
+            }
+        }
+        if (error > options.stepTolerance && level > 0) {
+            s.level = level - 1;
+            continue;
+        }
+
+        t += h_steps;
+        accepted++;
+        for (size_t i = 0; i < p.capacitors.size(); ++i) {
+            s.capVoltage[i] = nodeVoltage(x, p.capacitors[i].n1) - nodeVoltage(x, p.capacitors[i].n2);
+        }
+        for (size_t i = 0; i < p.inductors.size(); ++i) {
+            s.indCurrent[i] = x[m + p.voltageSources.size() + i];
+        }
+        s.x_prev = move(s.x);
+        s.x = x;
+        s.h_prev = h_steps;
+        s.steps++;
+        wave.times.push_back(t);
+        wave.values.push_back(move(x));
+
+        if (level == s.level && s.steps > 2 && error < 0.25 * options.stepTolerance && s.level < options.maxStepLevel) {
+            s.level++;
+        }
+    }
+    return accepted;
+}
+
+} // namespace
+
+bool waveformRelaxationAnalysis(Circuit& circuit, const WaveformRelaxationOptions& options,
+                                WaveformRelaxationResult& result) {
+    result = WaveformRelaxationResult();
+    if (options.t_step <= 0.0 || options.t_stop < options.t_step || options.windowSteps < 1 || options.maxIterations < 1) {
+        analysisErrors() << "Error: Invalid waveform relaxation settings." << endl;
+        return false;
+    }
+    if (!circuit.diodes.empty()) {
+        analysisErrors() << "Warning: Waveform relaxation needs a circuit without diodes, running the monolithic transient." << endl;
+        transientAnalysis(circuit, options.t_step, options.t_stop);
+        return !circuit.topology.rejected;
+    }
+
+    Circuit reference;
+    if (options.compareMonolithic) reference = circuit;
+
+    analysisOutput() << "// Performing Waveform Relaxation Transient Analysis..." << endl;
+    circuit.clearComponentHistory();
+    if (!transientOperatingPoint(circuit)) return false;
+
+    vector<Node*> nonGroundNodes;
+    for (auto* node : circuit.nodes) {
+        if (!node->isGround) {
+            nonGroundNodes.push_back(node);
+        }
+    }
+    for (auto* node : nonGroundNodes) {
+        node->addVoltageHistoryPoint(0.0, node->getVoltage());
+    }
+    for (auto& vs : circuit.voltageSources) {
+        vs.addCurrentHistoryPoint(0.0, vs.getCurrent());
+    }
+
+    // Same output steps as the loop in transientAnalysis
+    long long total_steps = 0;
+    for (double t = options.t_step; t <= options.t_stop; t += options.t_step) total_steps++;
+
+    const int n = nonGroundNodes.size();
+    auto terminals = [&](const Component& c) {
+        return Terminals{circuit.getNodeMatrixIndex(c.node1), circuit.getNodeMatrixIndex(c.node2)};
+    };
+
+    // Blocks: nodes tied by anything but a weak resistor. Only static conductance
+    // counts, since local steps may grow until capacitors barely load a node.
+    vector<double> stiffness(n, 0.0);
+    auto addStiffness = [&](const Terminals& c, double g) {
+        if (c.n1 != -1) stiffness[c.n1] += g;
+        if (c.n2 != -1) stiffness[c.n2] += g;
+    };
+    for (const auto& c : circuit.resistors) addStiffness(terminals(c), 1.0 / c.resistance);
+    for (const auto& c : circuit.voltageSources) {
+        Terminals t = terminals(c);
+        if (t.n1 == -1 || t.n2 == -1) addStiffness(t, numeric_limits<double>::infinity());
+    }
+
+    UnionFind blocks(n);
+    auto tie = [&](const Terminals& c) {
+        if (c.n1 != -1 && c.n2 != -1) blocks.unite(c.n1, c.n2);
+    };
+    auto isWeak = [&](const Terminals& c, double g) {
+        return c.n1 != -1 && c.n2 != -1 && c.n1 != c.n2 &&
+               g <= options.couplingRatio * (stiffness[c.n1] - g) && g <= options.couplingRatio * (stiffness[c.n2] - g);
+    };
+    for (const auto& c : circuit.resistors) {
+        Terminals t = terminals(c);
+        if (!isWeak(t, 1.0 / c.resistance)) tie(t);
+    }
+    for (const auto& c : circuit.capacitors) tie(terminals(c));
+    for (const auto& c : circuit.inductors) tie(terminals(c));
+    for (const auto& c : circuit.voltageSources) tie(terminals(c));
+    for (const auto& c : circuit.currentSources) tie(terminals(c));
+
+    vector<vector<int>> groups;
+    {
+        vector<int> group_of(n, -1);
+        for (int i = 0; i < n; ++i) {
+            int root = blocks.find(i);
+            if (group_of[root] == -1) {
+                group_of[root] = groups.size();
+                groups.emplace_back();
+            }
+            groups[group_of[root]].push_back(i);
+        }
+    }
+    // Largest blocks first into the emptiest partition
+    if (options.maxPartitions > 0 && (int)groups.size() > options.maxPartitions) {
+        vector<int> order(groups.size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](int a, int b) { return groups[a].size() > groups[b].size(); });
+        vector<vector<int>> bins(options.maxPartitions);
+        for (int g : order) {
+            auto emptiest = min_element(bins.begin(), bins.end(),
+                                        [](const vector<int>& a, const vector<int>& b) { return a.size() < b.size(); });
+            emptiest->insert(emptiest->end(), groups[g].begin(), groups[g].end());
+        }
+        for (auto& bin : bins) sort(bin.begin(), bin.end());
+        groups = move(bins);
+    }
+
+    const int P = groups.size();
+    vector<int> owner(n), local(n);
+    vector<Partition> partitions(P);
+    for (int p = 0; p < P; ++p) {
+        partitions[p].nodes = groups[p];
+        for (size_t i = 0; i < groups[p].size(); ++i) {
+            owner[groups[p][i]] = p;
+            local[groups[p][i]] = i;
+        }
+    }
+
+    // Components go to the partition of their non-ground terminal, in circuit order
+    auto place = [&](const Terminals& c, Terminals& localTerminals) -> Partition* {
+        int anchor = c.n1 != -1 ? c.n1 : c.n2;
+        if (anchor == -1) return nullptr;
+        localTerminals = {c.n1 != -1 ? local[c.n1] : -1, c.n2 != -1 ? local[c.n2] : -1};
+        return &partitions[owner[anchor]];
+    };
+    vector<vector<char>> isBoundary(P);
+    for (int p = 0; p < P; ++p) isBoundary[p].assign(partitions[p].nodes.size(), 0);
+    for (const auto& c : circuit.resistors) {
+        Terminals t = terminals(c), lt;
+        double g = 1.0 / c.resistance;
+        if (t.n1 != -1 && t.n2 != -1 && owner[t.n1] != owner[t.n2]) {
+            partitions[owner[t.n1]].couplings.push_back({local[t.n1], t.n2, g});
+            partitions[owner[t.n2]].couplings.push_back({local[t.n2], t.n1, g});
+            isBoundary[owner[t.n1]][local[t.n1]] = 1;
+            isBoundary[owner[t.n2]][local[t.n2]] = 1;
+            continue;
+        }
+        if (Partition* p = place(t, lt)) {
+            p->resistors.push_back(lt);
+            p->conductance.push_back(g);
+        }
+    }
+    for (const auto& c : circuit.capacitors) {
+        Terminals lt;
+        if (Partition* p = place(terminals(c), lt)) {
+            p->capacitors.push_back(lt);
+            p->capacitance.push_back(c.capacitance);
+        }
+    }
+    for (size_t i = 0; i < circuit.inductors.size(); ++i) {
+        Terminals lt;
+        if (Partition* p = place(terminals(circuit.inductors[i]), lt)) {
+            p->inductors.push_back(lt);
+            p->inductance.push_back(circuit.inductors[i].inductance);
+            p->inductorIndex.push_back(i);
+        }
+    }
+    for (size_t i = 0; i < circuit.voltageSources.size(); ++i) {
+        Terminals lt;
+        if (Partition* p = place(terminals(circuit.voltageSources[i]), lt)) {
+            p->voltageSources.push_back(lt);
+            p->voltage.push_back(circuit.voltageSources[i].value * circuit.sourceScale);
+            p->voltageSourceIndex.push_back(i);
+        }
+    }
+    for (const auto& c : circuit.currentSources) {
+        Terminals lt;
+        if (Partition* p = place(terminals(c), lt)) {
+            p->currentSources.push_back(lt);
+            p->current.push_back(c.value * circuit.sourceScale);
+        }
+    }
+
+    // transientAnalysis integrates from zero capacitor voltages and inductor currents
+    vector<PartitionState> states(P);
+    for (int i : circuit.topology.shuntNodes) {
+        partitions[owner[i]].shuntNodes.push_back(local[i]);
+    }
+    for (int p = 0; p < P; ++p) {
+        Partition& part = partitions[p];
+        part.n = part.nodes.size();
+        part.shuntConductance = circuit.topology.shuntConductance;
+        part.N = part.n + part.voltageSources.size() + part.inductors.size();
+        for (size_t i = 0; i < isBoundary[p].size(); ++i) {
+            if (isBoundary[p][i]) part.boundary.push_back(i);
+        }
+        PartitionState& s = states[p];
+        s.x.assign(part.N, 0.0);
+        for (size_t i = 0; i < part.nodes.size(); ++i) s.x[i] = nonGroundNodes[part.nodes[i]]->getVoltage();
+        for (size_t i = 0; i < part.voltageSourceIndex.size(); ++i) {
+            s.x[part.nodes.size() + i] = circuit.voltageSources[part.voltageSourceIndex[i]].getCurrent();
+        }
+        s.capVoltage.assign(part.capacitors.size(), 0.0);
+        s.indCurrent.assign(part.inductors.size(), 0.0);
+        result.partitionNodes.push_back(part.nodes.size());
+    }
+    result.partitions = P;
+    result.partitionSteps.assign(P, 0);
+
+    ThreadPool& pool = ThreadPool::shared();
+    const double gmin = circuit.gmin;
+    vector<Waveform> waves(P);
+    vector<long long> evaluated(P, 0), bypassed(P, 0);
+    for (long long t0 = 0; t0 < total_steps; t0 += options.windowSteps) {
+        const long long t1 = min<long long>(t0 + options.windowSteps, total_steps);
+        result.windows++;
+
+        // First sweep sees every other partition hold its window-start voltages
+        for (int p = 0; p < P; ++p) {
+            waves[p].times.assign(1, t0);
+            waves[p].values.assign(1, states[p].x);
+        }
+
+        vector<PartitionState> trial;
+        vector<long long> steps(P);
+        bool converged = false;
+        for (int sweep = 0; sweep < options.maxIterations && !converged; ++sweep) {
+            result.iterations++;
+            trial = states;
+            vector<Waveform> fresh(P);
+            vector<double> change(P, 0.0);
+
+            auto run = [&](int p, const vector<Waveform>& inputs) {
+                auto remote = [&](int node, long long t) { return inputs[owner[node]].at(t, local[node]); };
+                if (options.latencyBypass && isLatent(partitions[p], trial[p], t0, t1, remote, options.latencyTolerance)) {
+                    fresh[p].times = {t0, t1};
+                    fresh[p].values.assign(2, trial[p].x);
+                    steps[p] = 0;
+                    bypassed[p] += partitions[p].devices() * (t1 - t0);
+                } else {
+                    long long solves = 0;
+                    // After a bypass, integrate from where the state was left so the held windows are caught up
+                    steps[p] = integrate(partitions[p], trial[p], trial[p].integrated, t1, remote, options, gmin, fresh[p], solves);
+                    evaluated[p] += partitions[p].devices() * solves;
+                    trial[p].integrated = t1;
+                    trial[p].inputs.clear();
+                    for (const Coupling& c : partitions[p].couplings) trial[p].inputs.push_back(remote(c.remote, t1));
+                }
+                for (int i : partitions[p].boundary) {
+                    for (long long t = t0 + 1; t <= t1; ++t) {
+                        change[p] = max(change[p], abs(fresh[p].at(t, i) - waves[p].at(t, i)));
+                    }
+                }
+            };
+            if (options.relaxation == RelaxationType::JACOBI) {
+                pool.parallelForDynamic(P, 1, [&](size_t begin, size_t end) {
+                    for (size_t p = begin; p < end; ++p) run(p, waves);
+                });
+                waves = move(fresh);
+            } else {
+                for (int p = 0; p < P; ++p) {
+                    run(p, waves);
+                    waves[p] = move(fresh[p]);
+                }
+            }
+            converged = *max_element(change.begin(), change.end()) <= options.tolerance;
+        }
+        if (!converged) {
+            result.unconvergedWindows++;
+            analysisErrors() << "Warning: Waveform relaxation did not converge in " << options.maxIterations
+                             << " sweeps for the window ending at t=" << t1 * options.t_step << endl;
+        }
+        states = move(trial);
+        for (int p = 0; p < P; ++p) result.partitionSteps[p] += steps[p];
+
+        for (long long t = t0 + 1; t <= t1; ++t) {
+            double time = t * options.t_step;
+            for (int i = 0; i < n; ++i) {
+                nonGroundNodes[i]->addVoltageHistoryPoint(time, waves[owner[i]].at(t, local[i]));
+            }
+            for (int p = 0; p < P; ++p) {
+                const Partition& part = partitions[p];
+                for (size_t i = 0; i < part.voltageSourceIndex.size(); ++i) {
+                    circuit.voltageSources[part.voltageSourceIndex[i]].addCurrentHistoryPoint(
+                        time, waves[p].at(t, part.nodes.size() + i));
+                }
+            }
+        }
+    }
+
+    // Leave the final point in the circuit, as the last step of transientAnalysis does
+    for (int p = 0; p < P; ++p) {
+        const Partition& part = partitions[p];
+        const PartitionState& s = states[p];
+        const int m = part.nodes.size();
+        for (int i = 0; i < m; ++i) nonGroundNodes[part.nodes[i]]->setVoltage(s.x[i]);
+        for (size_t i = 0; i < part.voltageSourceIndex.size(); ++i) {
+            circuit.voltageSources[part.voltageSourceIndex[i]].setCurrent(s.x[m + i]);
+        }
+        for (size_t i = 0; i < part.inductorIndex.size(); ++i) {
+            Inductor& ind = circuit.inductors[part.inductorIndex[i]];
+            ind.setInductorCurrent(s.indCurrent[i]);
+            ind.prevCurrent = s.indCurrent[i];
+        }
+    }
+    for (auto& cap : circuit.capacitors) cap.update(options.t_step);
+    circuit.setDeltaT(options.t_step);
+
+    result.deviceEvaluations = accumulate(evaluated.begin(), evaluated.end(), 0LL);
+    result.bypassedEvaluations = accumulate(bypassed.begin(), bypassed.end(), 0LL);
+
+    long long fewest = *min_element(result.partitionSteps.begin(), result.partitionSteps.end());
+    long long most = *max_element(result.partitionSteps.begin(), result.partitionSteps.end());
+    analysisOutput() << "// Waveform relaxation: " << P << " partition(s), " << result.windows << " window(s), "
+                     << result.iterations << " sweep(s), " << fewest << " to " << most << " local steps per partition." << endl;
+    if (options.latencyBypass) {
+        long long total = result.deviceEvaluations + result.bypassedEvaluations;
+        analysisOutput() << "// Latency bypass skipped " << (total > 0 ? 100.0 * result.bypassedEvaluations / total : 0.0)
+                         << "% of device evaluations." << endl;
+    }
+
+    if (options.compareMonolithic) {
+        bool wasQuiet = setThreadQuiet(true);
+        transientAnalysis(reference, options.t_step, options.t_stop);
+        setThreadQuiet(wasQuiet);
+        result.maxDeviation = 0.0;
+        for (size_t k = 0; k < circuit.nodes.size(); ++k) {
+            const auto& ours = circuit.nodes[k]->voltage_history;
+            const auto& theirs = reference.nodes[k]->voltage_history;
+            for (size_t j = 0; j < min(ours.size(), theirs.size()); ++j) {
+                result.maxDeviation = max(result.maxDeviation, abs(ours[j].second - theirs[j].second));
+            }
+        }
+        analysisOutput() << "// Waveform relaxation differs from the monolithic transient by at most " << result.maxDeviation << " V." << endl;
+    }
+
+    // A singular partition shows up as non-finite voltages, not as a failed solve
+    for (const Node* node : nonGroundNodes) {
+        for (const auto& point : node->voltage_history) {
+            if (isfinite(point.second)) continue;
+            analysisErrors() << "Error: Waveform relaxation produced a non-finite voltage at node " << node->name << "." << endl;
+            return false;
+        }
+    }
+
+    analysisOutput() << "// Waveform Relaxation Transient Analysis complete." << endl;
+    return result.unconvergedWindows == 0;
+}